@@ -0,0 +1,58 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "pattern_database_generator.cpp"
+
+using std::cout;
+using std::endl;
+
+/**
+ * Computes the exact number of states at each distance from solved, for subgroups of the cube.
+ *
+ * Usage: Analyse [2x2|ur|corners|edges] [threads]
+ *
+ *  - 2x2     : the 2x2x2 cube (the corners, with U, R and F)
+ *  - ur      : the <U,R> group
+ *  - corners : the corners of the 3x3x3, with all the moves
+ *  - edges   : 6 of the edges of the 3x3x3, with all the moves
+ */
+
+template <class Pattern>
+void analyse(const Pattern& pattern, unsigned threads) {
+    PatternDatabaseGenerator<Pattern> generator(pattern, threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> counts = generator.run({CubeState()}, [](int, const std::atomic<uint64_t>*, uint64_t) { });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t total = 0;
+    for (size_t d = 0; d < counts.size(); d++) {
+        cout << d << "\t" << counts[d] << endl;
+        total += counts[d];
+    }
+    // The search uses 3 bitmaps of one bit per index
+    double bytes = 3.0 * ((pattern.size() + 63) / 64) * 8;
+    cout << "states       : " << total << endl;
+    cout << "max depth    : " << counts.size() - 1 << endl;
+    cout << "time         : " << seconds << " s (" << threads << " threads)" << endl;
+    cout << "states / s   : " << total / seconds << endl;
+    cout << "bytes / state: " << bytes / total << " (" << bytes / (1 << 20) << " MB)" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::string which = argc > 1 ? argv[1] : "2x2";
+    unsigned threads = argc > 2 ? std::stoi(argv[2]) : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    if (which == "2x2") analyse(SubgroupPattern::pocket_cube(), threads);
+    else if (which == "ur") analyse(SubgroupPattern::two_generator(), threads);
+    else if (which == "corners") analyse(CornerPattern(), threads);
+    else if (which == "edges") analyse(EdgePattern(0), threads);
+    else {
+        cout << "Usage: Analyse [2x2|ur|corners|edges] [threads]" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "pocket_solver.cpp"
+#include "reduction_solver.cpp"
+#include "state_io.cpp"
+
+using std::cout;
+using std::endl;
+
+/**
+ * Solves all the 3x3x3 states of a file (see `state_io.cpp`) with the two-phase solver, on
+ * `threads` threads.
+ */
+int solve_file(const std::string& path, unsigned threads)
+{
+    StateFileReader states;
+    if (!states.open(path)) {
+        cout << "Cannot read " << path << endl;
+        return 1;
+    }
+    const TwoPhaseSolver& solver = TwoPhaseSolver::instance();
+    std::atomic<uint64_t> next(0), moves(0), failed(0);
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        std::vector<Move> solution;
+        CubeState s;
+        for (uint64_t i = next++; i < states.states(); i = next++) {
+            if (!states.read(i, s) || !solver.solve(s, solution)) {
+                failed++;
+                continue;
+            }
+            s.apply(solution);
+            if (!s.is_solved()) failed++;
+            moves += solution.size();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& t: pool) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t solved = states.states() - failed;
+    cout << solved << " states solved, " << failed << " failed: " << double(moves) / std::max<uint64_t>(solved, 1)
+         << " moves, " << states.states() / seconds << " states / s" << endl;
+    return failed ? 1 : 0;
+}
+
+/**
+ * Scrambles NxNxN cubes with random layer turns and solves them by reduction.
+ *
+ * Usage: BigSolve [size] [cubes] [threads]
+ *        BigSolve <states file> [threads]
+ *
+ * The 2x2x2 solutions are also checked against the optimal ones (`PocketCubeSolver`).
+ */
+int main(int argc, char** argv)
+{
+    if (argc > 1 && !std::isdigit(static_cast<unsigned char>(argv[1][0]))) {
+        unsigned threads = argc > 2 ? std::stoi(argv[2]) : std::thread::hardware_concurrency();
+        return solve_file(argv[1], threads ? threads : 1);
+    }
+
+    int size = argc > 1 ? std::stoi(argv[1]) : 7;
+    int cubes = argc > 2 ? std::stoi(argv[2]) : 10;
+    unsigned threads = argc > 3 ? std::stoi(argv[3]) : std::thread::hardware_concurrency();
+    if (size < 2) size = 2;
+
+    ReductionSolver solver(threads);
+    PocketCubeSolver oracle(threads);
+    bool check = size == 2 && oracle.load();
+    size_t optimal_moves = 0;
+    std::mt19937 random(42);
+    double total = 0, worst = 0;
+    size_t moves = 0;
+    for (int c = 0; c < cubes; c++) {
+        FaceletCube cube(size);
+        for (int i = 0; i < 20 * size; i++)
+            cube.turn(Face(random() % 6), random() % size, 1 + random() % 3);
+
+        std::vector<Move> optimal;
+        if (check) oracle.solve(cube, optimal);
+
+        // The first solve also builds the tables of this size
+        auto start = std::chrono::steady_clock::now();
+        std::vector<LayerMove> solution;
+        bool ok = solver.solve(cube, solution);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (const LayerMove& m: solution) cube.turn(m);
+        if (!ok || !cube.is_solved() || solution.size() < optimal.size()) {
+            cout << "cube " << c << ": not solved" << endl;
+            return 1;
+        }
+        optimal_moves += optimal.size();
+        cout << "cube " << c << ": " << solution.size() << " moves in " << seconds << " s" << endl;
+        total += seconds;
+        worst = std::max(worst, seconds);
+        moves += solution.size();
+    }
+    cout << "average: " << double(moves) / cubes << " moves in " << total / cubes << " s (worst " << worst << " s)" << endl;
+    if (check) cout << "optimal: " << double(optimal_moves) / cubes << " moves" << endl;
+    return 0;
+}
@@ -0,0 +1,295 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+/**
+ * Export of the rendered frames, as images or as a video.
+ *
+ * The frames arrive as RGBA rows from the bottom of the image to the top (the order of
+ * `glReadPixels`), and are written from the top down.
+ */
+
+/**
+ * Writes each frame to `<prefix><frame number, 5 digits>.png`.
+ *
+ * The PNG is not compressed (stored deflate blocks): the frames are written as fast as
+ * they come, and can be compressed afterwards by any tool.
+ */
+class PngSequenceWriter {
+public:
+    PngSequenceWriter(std::string _prefix, int _width, int _height)
+        : prefix(std::move(_prefix)), width(_width), height(_height) { }
+
+    /// @return Returns false if the file cannot be written
+    bool operator()(const uint8_t* rgba, uint64_t frame) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%05llu.png", (unsigned long long)frame);
+        std::FILE* file = std::fopen((prefix + number).c_str(), "wb");
+        if (!file) return false;
+        encode(rgba);
+        bool ok = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+private:
+    std::string prefix;
+    int width, height;
+    std::vector<uint8_t> png;
+
+    void encode(const uint8_t* rgba) {
+        png.clear();
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        png.insert(png.end(), signature, signature + 8);
+
+        size_t start = begin_chunk("IHDR");
+        put32(width);
+        put32(height);
+        // 8 bits per channel, RGBA, default compression, filter and no interlace
+        const uint8_t format[5] = {8, 6, 0, 0, 0};
+        png.insert(png.end(), format, format + 5);
+        end_chunk(start);
+
+        // zlib stream of stored blocks: each row is its filter byte (none) and its pixels
+        start = begin_chunk("IDAT");
+        png.push_back(0x78);
+        png.push_back(0x01);
+        size_t row_bytes = size_t(width) * 4;
+        size_t remaining = (row_bytes + 1) * height;
+        uint32_t a = 1, b = 0;
+        size_t block_left = 0;
+        auto put_byte = [&](uint8_t value) {
+            if (block_left == 0) {
+                block_left = std::min<size_t>(remaining, 65535);
+                remaining -= block_left;
+                png.push_back(remaining == 0 ? 1 : 0);
+                png.push_back(block_left & 0xFF);
+                png.push_back(block_left >> 8);
+                png.push_back(~block_left & 0xFF);
+                png.push_back((~block_left >> 8) & 0xFF);
+            }
+            png.push_back(value);
+            block_left--;
+            a = (a + value) % 65521;
+            b = (b + a) % 65521;
+        };
+        for (int y = height - 1; y >= 0; y--) {
+            put_byte(0);
+            const uint8_t* row = rgba + y * row_bytes;
+            for (size_t i = 0; i < row_bytes; i++) put_byte(row[i]);
+        }
+        put32((b << 16) | a);
+        end_chunk(start);
+
+        end_chunk(begin_chunk("IEND"));
+    }
+
+    void put32(uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) png.push_back(value >> shift);
+    }
+
+    /// @return Returns the position of the chunk, for `end_chunk`
+    size_t begin_chunk(const char* type) {
+        size_t start = png.size();
+        put32(0);
+        png.insert(png.end(), type, type + 4);
+        return start;
+    }
+
+    /// Writes the length and the CRC of the chunk that starts at `start`
+    void end_chunk(size_t start) {
+        uint32_t length = png.size() - start - 8;
+        for (int i = 0; i < 4; i++) png[start + i] = length >> (24 - 8 * i);
+        put32(crc32(&png[start + 4], length + 4));
+    }
+
+    static uint32_t crc32(const uint8_t* data, size_t size) {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        uint32_t c = 0xFFFFFFFF;
+        for (size_t i = 0; i < size; i++) c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+        return c ^ 0xFFFFFFFF;
+    }
+};
+
+/**
+ * Writes the frames as a raw video in the YUV4MPEG2 format (read by ffmpeg, mpv, x264...):
+ * 4:4:4, BT.601 limited range.
+ */
+class Y4mWriter {
+public:
+    Y4mWriter(std::FILE* _file, int _width, int _height, int _fps = 60)
+        : file(_file), width(_width), height(_height), fps(_fps), planes(size_t(_width) * _height * 3) { }
+
+    /// @return Returns false if the frame cannot be written
+    bool operator()(const uint8_t* rgba, uint64_t frame) {
+        if (frame == 0 && std::fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps) < 0)
+            return false;
+        size_t pixels = size_t(width) * height;
+        uint8_t* y_plane = planes.data();
+        uint8_t* u_plane = y_plane + pixels;
+        uint8_t* v_plane = u_plane + pixels;
+        for (int y = 0; y < height; y++) {
+            const uint8_t* row = rgba + size_t(height - 1 - y) * width * 4;
+            for (int x = 0; x < width; x++) {
+                int r = row[4 * x], g = row[4 * x + 1], b = row[4 * x + 2];
+                size_t i = size_t(y) * width + x;
+                y_plane[i] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                u_plane[i] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                v_plane[i] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+        return std::fputs("FRAME\n", file) >= 0 && std::fwrite(planes.data(), 1, planes.size(), file) == planes.size()
+            && std::fflush(file) == 0;
+    }
+
+private:
+    std::FILE* file;
+    int width, height, fps;
+    std::vector<uint8_t> planes;
+};
+
+/**
+ * Reads back the frames rendered without stalling the rendering, and writes them on a
+ * thread of their own.
+ *
+ * `capture` starts the copy of the framebuffer into one of `BUFFERS` pixel buffer objects,
+ * and only maps the buffer filled `BUFFERS` frames earlier, whose copy is done by then.
+ * Its pixels go to the writer thread, through a few frames allocated once: if the writer is
+ * slower than the rendering, `capture` waits for it rather than piling up frames.
+ */
+class FrameCapture {
+public:
+    static constexpr int BUFFERS = 3;
+    static constexpr int QUEUED_FRAMES = 4;
+
+    /// `write` is called on the writer thread, for each frame in order, and returns false on an error
+    using Writer = std::function<bool(const uint8_t* rgba, uint64_t frame)>;
+
+    FrameCapture(int _width, int _height, Writer _write)
+        : width(_width), height(_height), write(std::move(_write)) {
+        size_t bytes = frame_bytes();
+        glGenBuffers(BUFFERS, pbos);
+        for (int i = 0; i < BUFFERS; i++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        for (int i = 0; i < QUEUED_FRAMES; i++) free_frames.emplace_back(bytes);
+        writer = std::thread([this] { write_frames(); });
+    }
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    ~FrameCapture() { finish(); }
+
+    size_t frame_bytes() const { return size_t(width) * height * 4; }
+
+    /// Frames captured so far
+    uint64_t frames() const { return captured; }
+
+    /// Captures the framebuffer bound for reading (the frame just rendered)
+    void capture() {
+        int i = captured % BUFFERS;
+        if (captured >= BUFFERS) send(i);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        captured++;
+    }
+
+    /**
+     * Sends the frames still in the buffers, and waits for all of them to be written.
+     * @return Returns false if a frame could not be written
+     */
+    bool finish() {
+        if (!writer.joinable()) return ok;
+        for (uint64_t f = captured < BUFFERS ? 0 : captured - BUFFERS; f < captured; f++)
+            send(f % BUFFERS);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        changed.notify_all();
+        writer.join();
+        glDeleteBuffers(BUFFERS, pbos);
+        return ok;
+    }
+
+private:
+    int width, height;
+    Writer write;
+    unsigned int pbos[BUFFERS];
+    uint64_t captured = 0;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> free_frames, pending;
+    bool done = false;
+    bool ok = true;
+
+    /// Copies the pixels of a buffer into a free frame, for the writer
+    void send(int i) {
+        std::vector<uint8_t> frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return !free_frames.empty(); });
+            frame.swap(free_frames.front());
+            free_frames.pop_front();
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.size(), GL_MAP_READ_BIT);
+        if (pixels) std::memcpy(frame.data(), pixels, frame.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!pixels) ok = false;
+            pending.push_back(std::move(frame));
+        }
+        changed.notify_all();
+    }
+
+    void write_frames() {
+        for (uint64_t index = 0;; index++) {
+            std::vector<uint8_t> frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this] { return done || !pending.empty(); });
+                if (pending.empty()) return;
+                frame.swap(pending.front());
+                pending.pop_front();
+            }
+            bool written = write(frame.data(), index);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!written) ok = false;
+                free_frames.push_back(std::move(frame));
+            }
+            changed.notify_all();
+        }
+    }
+};
+
+#endif
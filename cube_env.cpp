@@ -0,0 +1,35 @@
+#include "cube_env.h"
+#include "environment.cpp"
+
+struct CubeEnv {
+    CubeEnvironment environment;
+};
+
+extern "C" {
+
+CubeEnv* cube_env_create(int count, int scramble_depth, int max_steps, uint64_t seed) {
+    if (count <= 0) return nullptr;
+    return new CubeEnv{CubeEnvironment(count, scramble_depth, max_steps, seed)};
+}
+
+void cube_env_destroy(CubeEnv* env) { delete env; }
+
+int cube_env_count(const CubeEnv* env) { return env->environment.size(); }
+
+int cube_env_observation_words(void) { return CubeEnvironment::OBSERVATION_WORDS; }
+
+const uint64_t* cube_env_observations(const CubeEnv* env) { return env->environment.observation_data(); }
+
+void cube_env_set_scramble_depth(CubeEnv* env, int scramble_depth) { env->environment.set_scramble_depth(scramble_depth); }
+
+void cube_env_reset(CubeEnv* env) { env->environment.reset(); }
+
+int cube_env_step(CubeEnv* env, const int32_t* actions, float* rewards, uint8_t* dones) {
+    return env->environment.step(actions, rewards, dones) ? 0 : -1;
+}
+
+void cube_env_facelets(const CubeEnv* env, int index, uint8_t* facelets) {
+    env->environment.state(index).to_facelets(facelets);
+}
+
+}
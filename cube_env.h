@@ -0,0 +1,64 @@
+#ifndef CUBE_ENV_H
+#define CUBE_ENV_H
+
+#include <stdint.h>
+
+/*
+ * C interface of `CubeEnvironment` (environment.cpp), built as the CubeEnv shared library:
+ * a batch of 3x3x3 cubes for reinforcement learning, stepped in one call.
+ *
+ * Actions are the 18 face turns, in the order U U2 U' R R2 R' F F2 F' D D2 D' L L2 L' B B2 B'.
+ * The observations are a buffer owned by the environment, `cube_env_observation_words()`
+ * 64 bits words per cube: bit 6 * sticker + color is set when that sticker has that color.
+ * The buffer does not move for the life of the environment, and each step updates it.
+ *
+ * An environment must not be used by two threads at once.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CubeEnv CubeEnv;
+
+/**
+ * Creates `count` cubes and starts an episode on each. A reset scrambles with
+ * `scramble_depth` random moves, or into a uniformly random state if it is 0. An episode
+ * ends when the cube is solved, or after `max_steps` moves.
+ * @return Returns NULL if `count` is not positive
+ */
+CubeEnv* cube_env_create(int count, int scramble_depth, int max_steps, uint64_t seed);
+
+void cube_env_destroy(CubeEnv* env);
+
+int cube_env_count(const CubeEnv* env);
+
+/// @return Returns the number of 64 bits words of the observation of one cube
+int cube_env_observation_words(void);
+
+/// @return Returns the observations of all the cubes, one after the other
+const uint64_t* cube_env_observations(const CubeEnv* env);
+
+/// Changes the scramble of the next resets (e.g. for a curriculum)
+void cube_env_set_scramble_depth(CubeEnv* env, int scramble_depth);
+
+/// Starts a new episode on every cube
+void cube_env_reset(CubeEnv* env);
+
+/**
+ * Turns each cube with its action. For each cube, `rewards` gets 1 if it is solved, 0
+ * otherwise, and `dones` gets 0 if its episode goes on, 1 if it is solved, 2 if it has used
+ * its moves. The cubes whose episode ended are reset at once. `rewards` and `dones` may be
+ * NULL.
+ * @return Returns 0, or -1 (and changes nothing) if an action is not in [0, 18)
+ */
+int cube_env_step(CubeEnv* env, const int32_t* actions, float* rewards, uint8_t* dones);
+
+/// Writes the 54 stickers of cube `index`, each as the face of its color (U R F D L B)
+void cube_env_facelets(const CubeEnv* env, int index, uint8_t* facelets);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,406 @@
+#ifndef CUBESTATE_H
+#define CUBESTATE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Logical model of the rubicscube, independent of OpenGL.
+ *
+ * `RubicsCube` knows where each cube is drawn, but it does not know which piece is where.
+ * The solvers and the analysis tools need the latter, so this file describes the cube as
+ * a permutation of pieces (the "cubie" model):
+ *
+ *  - 8 corners : URF, UFL, ULB, UBR, DFR, DLF, DBL, DRB
+ *  - 12 edges  : UR, UF, UL, UB, DR, DF, DL, DB, FR, FL, BL, BR
+ *
+ * For each position we store which piece is there and how it is twisted (0..2 for corners,
+ * 0..1 for edges).
+ *
+ * The faces are named with the usual notation. With the colors of `RubicsCube`, this gives
+ *
+ *      U = orange, R = blue, F = white, D = red, L = green, B = yellow
+ */
+
+enum Face : uint8_t {
+    FACE_U, FACE_R, FACE_F, FACE_D, FACE_L, FACE_B
+};
+
+/**
+ * The 18 face turns of the half-turn metric, ordered as face * 3 + (quarter turns - 1).
+ * Clockwise turns are the ones seen when looking at the face from outside the cube.
+ */
+enum Move : uint8_t {
+    U1, U2, U3,
+    R1, R2, R3,
+    F1, F2, F3,
+    D1, D2, D3,
+    L1, L2, L3,
+    B1, B2, B3,
+    MOVE_COUNT
+};
+
+/// @return Returns the face turned by a move
+constexpr Face move_face(Move m) { return Face(m / 3); }
+
+/// @return Returns the number of clockwise quarter turns of a move (1, 2 or 3)
+constexpr int move_power(Move m) { return m % 3 + 1; }
+
+/// @return Returns the move that cancels the given one
+constexpr Move move_inverse(Move m) { return Move(m - m % 3 + (2 - m % 3)); }
+
+/// @return Returns the move turning `f` by `power` clockwise quarter turns
+constexpr Move make_move(Face f, int power) { return Move(f * 3 + (power % 4 + 3) % 4); }
+
+/// @return Returns the face opposite to `f` (U and D, R and L, F and B)
+constexpr Face opposite_face(Face f) { return Face((f + 3) % 6); }
+
+/// Used as "previous face" at the start of a sequence
+constexpr int NO_FACE = 6;
+
+/**
+ * Returns the moves that can follow a move of `last_face` in a canonical sequence.
+ *
+ * Searches only need to try canonical sequences, as all the others have an equivalent
+ * canonical sequence of the same length or shorter:
+ *  - the same face is never turned twice in a row ("R R" is "R2"),
+ *  - two opposite faces commute ("L R" is "R L"), so they are only allowed in one order:
+ *    U before D, R before L, F before B.
+ *
+ * This brings the branching factor from 18 to about 13.35.
+ */
+inline const std::vector<Move>& canonical_successors(int last_face) {
+    static const std::array<std::vector<Move>, NO_FACE + 1> table = [] {
+        std::array<std::vector<Move>, NO_FACE + 1> t;
+        for (int last = 0; last <= NO_FACE; last++) {
+            for (int m = 0; m < MOVE_COUNT; m++) {
+                int face = move_face(Move(m));
+                if (last != NO_FACE && face == last) continue;
+                if (last != NO_FACE && face == opposite_face(Face(last)) && face < last) continue;
+                t[last].push_back(Move(m));
+            }
+        }
+        return t;
+    }();
+    return table[last_face];
+}
+
+/// @return Returns the move in the usual notation ("R", "R2", "R'")
+inline std::string move_name(Move m) {
+    static const char faces[] = "URFDLB";
+    std::string name(1, faces[move_face(m)]);
+    if (move_power(m) == 2) name += '2';
+    if (move_power(m) == 3) name += '\'';
+    return name;
+}
+
+/**
+ * Parses a sequence of moves written in the usual notation, e.g. "R U R' U2".
+ *
+ * Unknown characters are skipped.
+ */
+inline std::vector<Move> parse_moves(const std::string& text) {
+    static const std::string faces = "URFDLB";
+    std::vector<Move> moves;
+    for (size_t i = 0; i < text.size(); i++) {
+        size_t f = faces.find(text[i]);
+        if (f == std::string::npos) continue;
+        int power = 1;
+        if (i + 1 < text.size() && text[i + 1] == '2') { power = 2; i++; }
+        else if (i + 1 < text.size() && text[i + 1] == '\'') { power = 3; i++; }
+        moves.push_back(make_move(Face(f), power));
+    }
+    return moves;
+}
+
+/// @return Returns a sequence of moves in the usual notation, separated by spaces
+inline std::string format_moves(const std::vector<Move>& moves) {
+    std::string text;
+    for (Move m: moves) {
+        if (!text.empty()) text += ' ';
+        text += move_name(m);
+    }
+    return text;
+}
+
+/**
+ * Returns the shortest equivalent of a sequence of moves, in linear time.
+ *
+ * Consecutive moves of the same face are merged ("R R" is "R2", "U U'" disappears), also
+ * through a move of the opposite face as both commute ("L R L'" is "R"). Pairs of opposite
+ * faces are written in the canonical order (U before D, R before L, F before B).
+ */
+inline std::vector<Move> simplify_moves(const std::vector<Move>& moves) {
+    std::vector<Move> out;
+    out.reserve(moves.size());
+    for (Move m: moves) {
+        Face f = move_face(m);
+        // The move of the same face it can merge with: the last one, or the one before if
+        // the last one is on the opposite face.
+        int target = -1;
+        size_t n = out.size();
+        if (n >= 1 && move_face(out[n - 1]) == f) target = n - 1;
+        else if (n >= 2 && move_face(out[n - 1]) == opposite_face(f) && move_face(out[n - 2]) == f) target = n - 2;
+
+        if (target >= 0) {
+            int power = (move_power(out[target]) + move_power(m)) % 4;
+            if (power == 0) out.erase(out.begin() + target);
+            else out[target] = make_move(f, power);
+        } else if (n >= 1 && move_face(out[n - 1]) == opposite_face(f) && f < move_face(out[n - 1])) {
+            out.insert(out.end() - 1, m);
+        } else {
+            out.push_back(m);
+        }
+    }
+    return out;
+}
+
+class CubeState {
+public:
+    static constexpr int CORNERS = 8;
+    static constexpr int EDGES = 12;
+
+    /// Corner permutation: cp[i] is the corner located at position i
+    std::array<uint8_t, CORNERS> cp;
+    /// Corner orientation: twist of the corner located at position i
+    std::array<uint8_t, CORNERS> co;
+    /// Edge permutation: ep[i] is the edge located at position i
+    std::array<uint8_t, EDGES> ep;
+    /// Edge orientation: flip of the edge located at position i
+    std::array<uint8_t, EDGES> eo;
+
+    /// Builds the solved cube
+    CubeState() {
+        for (int i = 0; i < CORNERS; i++) { cp[i] = i; co[i] = 0; }
+        for (int i = 0; i < EDGES; i++) { ep[i] = i; eo[i] = 0; }
+    }
+
+    bool operator==(const CubeState& o) const {
+        return cp == o.cp && co == o.co && ep == o.ep && eo == o.eo;
+    }
+    bool operator!=(const CubeState& o) const { return !(*this == o); }
+
+    bool is_solved() const { return *this == CubeState(); }
+
+    /**
+     * Composition of two states: the result is `this` followed by `b`.
+     */
+    CubeState operator*(const CubeState& b) const {
+        CubeState r;
+        for (int i = 0; i < CORNERS; i++) {
+            r.cp[i] = cp[b.cp[i]];
+            r.co[i] = (co[b.cp[i]] + b.co[i]) % 3;
+        }
+        for (int i = 0; i < EDGES; i++) {
+            r.ep[i] = ep[b.ep[i]];
+            r.eo[i] = (eo[b.ep[i]] + b.eo[i]) % 2;
+        }
+        return r;
+    }
+
+    /// @return Returns the state that brings this one back to solved
+    CubeState inverse() const {
+        CubeState r;
+        for (int i = 0; i < CORNERS; i++) {
+            r.cp[cp[i]] = i;
+            r.co[cp[i]] = (3 - co[i]) % 3;
+        }
+        for (int i = 0; i < EDGES; i++) {
+            r.ep[ep[i]] = i;
+            r.eo[ep[i]] = eo[i];
+        }
+        return r;
+    }
+
+    /**
+     * Applies a face turn inplace.
+     */
+    void apply(Move m) {
+        *this = *this * moves()[m];
+    }
+
+    void apply(const std::vector<Move>& moves) {
+        for (Move m: moves) apply(m);
+    }
+
+    /// @return Returns a 64 bits hash of the state, suited for hash tables
+    uint64_t hash() const {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (int i = 0; i < CORNERS; i++) h = (h ^ (cp[i] * 3 + co[i])) * 0x100000001b3ull;
+        for (int i = 0; i < EDGES; i++) h = (h ^ (ep[i] * 2 + eo[i])) * 0x100000001b3ull;
+        // final avalanche, so that the low bits can be used as a bucket index
+        h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /**
+     * Writes the 54 stickers of the cube: face after face (in the order of `Face`), each face
+     * row by row as seen from outside (U with F at its bottom, D with F at its top, the others
+     * with U at their top). Each sticker holds the face it belongs to when solved.
+     */
+    void to_facelets(uint8_t* f) const {
+        for (int i = 0; i < 54; i++) f[i] = i / 9;
+        for (int i = 0; i < CORNERS; i++)
+            for (int n = 0; n < 3; n++)
+                f[corner_facelets()[i][(n + co[i]) % 3]] = corner_facelets()[cp[i]][n] / 9;
+        for (int i = 0; i < EDGES; i++)
+            for (int n = 0; n < 2; n++)
+                f[edge_facelets()[i][(n + eo[i]) % 2]] = edge_facelets()[ep[i]][n] / 9;
+    }
+
+    /**
+     * Reads the 54 stickers of a cube (see `to_facelets`).
+     * @return Returns false if the stickers do not describe a cube that can be solved
+     */
+    static bool from_facelets(const uint8_t* f, CubeState& s) {
+        return read_corners(f, s) && read_edges(f, s) && s.is_valid();
+    }
+
+    /**
+     * Reads the corners from the stickers, leaving the edges as they are.
+     * @return Returns false if a corner is unknown or appears twice
+     */
+    static bool read_corners(const uint8_t* f, CubeState& s) {
+        bool seen[CORNERS] = {};
+        for (int i = 0; i < CORNERS; i++) {
+            // The orientation is given by the position of the U or D sticker
+            int ori = 0;
+            while (ori < 3 && f[corner_facelets()[i][ori]] != FACE_U && f[corner_facelets()[i][ori]] != FACE_D) ori++;
+            if (ori == 3) return false;
+            int c1 = f[corner_facelets()[i][(ori + 1) % 3]], c2 = f[corner_facelets()[i][(ori + 2) % 3]];
+            int j = 0;
+            while (j < CORNERS && (corner_facelets()[j][1] / 9 != c1 || corner_facelets()[j][2] / 9 != c2)) j++;
+            if (j == CORNERS || seen[j] || f[corner_facelets()[i][ori]] != corner_facelets()[j][0] / 9) return false;
+            seen[j] = true;
+            s.cp[i] = j;
+            s.co[i] = ori;
+        }
+        return true;
+    }
+
+    /**
+     * Reads the edges from the stickers, leaving the corners as they are.
+     * @return Returns false if an edge is unknown or appears twice
+     */
+    static bool read_edges(const uint8_t* f, CubeState& s) {
+        bool seen[EDGES] = {};
+        for (int i = 0; i < EDGES; i++) {
+            int j = find_edge(f[edge_facelets()[i][0]], f[edge_facelets()[i][1]], s.eo[i]);
+            if (j < 0 || seen[j]) return false;
+            seen[j] = true;
+            s.ep[i] = j;
+        }
+        return true;
+    }
+
+    /**
+     * @return Returns the edge having the given colors (-1 if none), and sets `flip` to 1 if
+     * they are in the reverse order
+     */
+    static int find_edge(int a, int b, uint8_t& flip) {
+        for (int j = 0; j < EDGES; j++) {
+            int x = edge_facelets()[j][0] / 9, y = edge_facelets()[j][1] / 9;
+            if (a == x && b == y) { flip = 0; return j; }
+            if (a == y && b == x) { flip = 1; return j; }
+        }
+        return -1;
+    }
+
+    /// @return Returns the parity of the corner permutation (0 even, 1 odd)
+    int corner_parity() const { return parity(cp.data(), CORNERS); }
+
+    /// @return Returns the parity of the edge permutation (0 even, 1 odd)
+    int edge_parity() const { return parity(ep.data(), EDGES); }
+
+    /**
+     * @return Returns true if the state can be reached with face turns: the twists and the
+     * flips sum to 0, and both permutations have the same parity.
+     */
+    bool is_valid() const {
+        int twist = 0, flip = 0;
+        for (int i = 0; i < CORNERS; i++) twist += co[i];
+        for (int i = 0; i < EDGES; i++) flip += eo[i];
+        return twist % 3 == 0 && flip % 2 == 0 && corner_parity() == edge_parity();
+    }
+
+    /**
+     * Index of the stickers of each corner position, starting with the U or D sticker and
+     * going clockwise.
+     */
+    static const std::array<std::array<uint8_t, 3>, CORNERS>& corner_facelets() {
+        static const std::array<std::array<uint8_t, 3>, CORNERS> table = {{
+            {8, 9, 20}, {6, 18, 38}, {0, 36, 47}, {2, 45, 11},
+            {29, 26, 15}, {27, 44, 24}, {33, 53, 42}, {35, 17, 51},
+        }};
+        return table;
+    }
+
+    /// Index of the stickers of each edge position, starting with the U, D, F or B sticker
+    static const std::array<std::array<uint8_t, 2>, EDGES>& edge_facelets() {
+        static const std::array<std::array<uint8_t, 2>, EDGES> table = {{
+            {5, 10}, {7, 19}, {3, 37}, {1, 46}, {32, 16}, {28, 25},
+            {30, 43}, {34, 52}, {23, 12}, {21, 41}, {50, 39}, {48, 14},
+        }};
+        return table;
+    }
+
+    /**
+     * Returns the clockwise quarter turn of each face, in the order of `Face`.
+     */
+    static const std::array<CubeState, 6>& quarter_turns() {
+        static const std::array<CubeState, 6> turns = {
+            make({3, 0, 1, 2, 4, 5, 6, 7}, {0, 0, 0, 0, 0, 0, 0, 0},
+                 {3, 0, 1, 2, 4, 5, 6, 7, 8, 9, 10, 11}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}),
+            make({4, 1, 2, 0, 7, 5, 6, 3}, {2, 0, 0, 1, 1, 0, 0, 2},
+                 {8, 1, 2, 3, 11, 5, 6, 7, 4, 9, 10, 0}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}),
+            make({1, 5, 2, 3, 0, 4, 6, 7}, {1, 2, 0, 0, 2, 1, 0, 0},
+                 {0, 9, 2, 3, 4, 8, 6, 7, 1, 5, 10, 11}, {0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0}),
+            make({0, 1, 2, 3, 5, 6, 7, 4}, {0, 0, 0, 0, 0, 0, 0, 0},
+                 {0, 1, 2, 3, 5, 6, 7, 4, 8, 9, 10, 11}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}),
+            make({0, 2, 6, 3, 4, 1, 5, 7}, {0, 1, 2, 0, 0, 2, 1, 0},
+                 {0, 1, 10, 3, 4, 5, 9, 7, 8, 2, 6, 11}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}),
+            make({0, 1, 3, 7, 4, 5, 2, 6}, {0, 0, 1, 2, 0, 0, 2, 1},
+                 {0, 1, 2, 11, 4, 5, 6, 10, 8, 9, 3, 7}, {0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1}),
+        };
+        return turns;
+    }
+
+    /**
+     * Returns the state reached from solved by each of the 18 moves.
+     */
+    static const std::array<CubeState, MOVE_COUNT>& moves() {
+        static const std::array<CubeState, MOVE_COUNT> table = [] {
+            std::array<CubeState, MOVE_COUNT> t;
+            for (int m = 0; m < MOVE_COUNT; m++) {
+                const CubeState& turn = quarter_turns()[move_face(Move(m))];
+                t[m] = turn;
+                for (int k = 1; k < move_power(Move(m)); k++)
+                    t[m] = t[m] * turn;
+            }
+            return t;
+        }();
+        return table;
+    }
+
+private:
+    static int parity(const uint8_t* p, int n) {
+        int inversions = 0;
+        for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n; j++)
+                if (p[j] < p[i]) inversions++;
+        return inversions % 2;
+    }
+
+    static CubeState make(std::array<uint8_t, CORNERS> _cp, std::array<uint8_t, CORNERS> _co,
+                          std::array<uint8_t, EDGES> _ep, std::array<uint8_t, EDGES> _eo) {
+        CubeState s;
+        s.cp = _cp; s.co = _co; s.ep = _ep; s.eo = _eo;
+        return s;
+    }
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "cubestate.cpp"
+#include "scrambler.cpp"
+#include "xoshiro.cpp"
+
+/**
+ * Reinforcement learning environment over a batch of 3x3x3 cubes, stepped all at once.
+ *
+ * The observation of a cube is its 54 stickers, one-hot over the 6 colors, packed in bits:
+ * bit 6 * sticker + color (stickers in the order of `CubeState::to_facelets`), in
+ * `OBSERVATION_WORDS` words of 64 bits per cube. The observations of the whole batch are one
+ * array owned by the environment and updated in place, so that a trainer can wrap it once
+ * as a tensor.
+ *
+ * An action is a `Move`. A step gives a reward of 1 to the cubes it solves, 0 to the others.
+ * An episode ends when the cube is solved, or after `max_steps` moves; the cube is then
+ * reset at once, and its observation is the start of its next episode.
+ *
+ * A reset scrambles with `scramble_depth` random moves (never undoing the previous one), or
+ * into a uniformly random state if `scramble_depth` is 0.
+ */
+class CubeEnvironment {
+public:
+    static constexpr int OBSERVATION_BITS = 54 * 6;
+    static constexpr int OBSERVATION_WORDS = (OBSERVATION_BITS + 63) / 64;
+
+    /// Why an episode ended, in the `dones` of a step
+    enum Done : uint8_t { RUNNING = 0, SOLVED = 1, OUT_OF_STEPS = 2 };
+
+    CubeEnvironment(int count, int _scramble_depth = 0, int _max_steps = 50, uint64_t seed = 42)
+        : states(count), steps(count, 0), observations(size_t(count) * OBSERVATION_WORDS, 0),
+          scramble_depth(_scramble_depth), max_steps(_max_steps), scrambler(seed), random(seed) {
+        random.jump();
+        reset();
+    }
+
+    int size() const { return int(states.size()); }
+
+    const CubeState& state(int i) const { return states[i]; }
+
+    /// @return Returns the `OBSERVATION_WORDS` words of each cube, one cube after the other
+    const uint64_t* observation_data() const { return observations.data(); }
+
+    void set_scramble_depth(int depth) { scramble_depth = depth; }
+
+    void set_max_steps(int steps) { max_steps = steps; }
+
+    /// Starts a new episode on every cube
+    void reset() {
+        for (int i = 0; i < size(); i++) reset(i);
+    }
+
+    /// Starts a new episode on one cube
+    void reset(int i) {
+        if (scramble_depth > 0) {
+            CubeState s;
+            int last_face = NO_FACE;
+            for (int d = 0; d < scramble_depth; d++) {
+                const std::vector<Move>& moves = canonical_successors(last_face);
+                Move m = moves[random.below(moves.size())];
+                s.apply(m);
+                last_face = move_face(m);
+            }
+            states[i] = s;
+        } else {
+            states[i] = scrambler.random_state();
+        }
+        steps[i] = 0;
+        observe(i);
+    }
+
+    /**
+     * Turns cube i with `actions[i]`, for every cube. `rewards` and `dones` (one per cube) are
+     * optional.
+     * @return Returns false, and changes nothing, if an action is not a move
+     */
+    bool step(const int32_t* actions, float* rewards, uint8_t* dones) {
+        for (int i = 0; i < size(); i++)
+            if (actions[i] < 0 || actions[i] >= MOVE_COUNT) return false;
+
+        for (int i = 0; i < size(); i++) {
+            states[i].apply(Move(actions[i]));
+            Done done = RUNNING;
+            if (states[i].is_solved()) done = SOLVED;
+            else if (++steps[i] >= max_steps) done = OUT_OF_STEPS;
+
+            if (rewards) rewards[i] = done == SOLVED ? 1.0f : 0.0f;
+            if (dones) dones[i] = done;
+            if (done == RUNNING) observe(i);
+            else reset(i);
+        }
+        return true;
+    }
+
+private:
+    std::vector<CubeState> states;
+    std::vector<int> steps;
+    std::vector<uint64_t> observations;
+    int scramble_depth;
+    int max_steps;
+    Scrambler scrambler;
+    Xoshiro256 random;
+
+    void observe(int i) {
+        uint8_t f[54];
+        states[i].to_facelets(f);
+        uint64_t* o = &observations[size_t(i) * OBSERVATION_WORDS];
+        std::memset(o, 0, OBSERVATION_WORDS * sizeof(uint64_t));
+        for (int k = 0; k < 54; k++) {
+            int bit = 6 * k + f[k];
+            o[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+};
+
+#endif
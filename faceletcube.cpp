@@ -0,0 +1,217 @@
+#ifndef FACELETCUBE_H
+#define FACELETCUBE_H
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "cubestate.cpp"
+
+/**
+ * A face turn of a NxNxN cube: `layer` 0 is the face itself, `layer` 1 the slice below it, ...
+ */
+struct LayerMove {
+    Face face;
+    uint8_t layer;
+    /// Number of clockwise quarter turns (1, 2 or 3)
+    uint8_t power;
+
+    LayerMove inverse() const { return {face, layer, uint8_t(4 - power)}; }
+};
+
+/**
+ * Simplifies a sequence of layer turns. All the turns around one axis commute, so the
+ * consecutive turns of an axis are merged layer by layer, and the turns that cancel are
+ * dropped. The turns of D, L and B are written as turns of U, R and F.
+ */
+inline std::vector<LayerMove> simplify_layer_moves(const std::vector<LayerMove>& moves, int size) {
+    std::vector<LayerMove> out;
+    for (LayerMove m: moves) {
+        if (m.face >= FACE_D) m = {opposite_face(m.face), uint8_t(size - 1 - m.layer), uint8_t(4 - m.power)};
+        // The turns around the same axis at the end of the output
+        size_t run = out.size();
+        while (run > 0 && out[run - 1].face == m.face) run--;
+        size_t j = run;
+        while (j < out.size() && out[j].layer != m.layer) j++;
+        if (j == out.size()) {
+            out.push_back(m);
+            continue;
+        }
+        out[j].power = (out[j].power + m.power) % 4;
+        if (out[j].power == 0) out.erase(out.begin() + j);
+    }
+    return out;
+}
+
+/**
+ * Logical model of a NxNxN cube, as an array of facelets (the colored stickers).
+ *
+ * The facelets are stored face after face (in the order of `Face`), each face row by row as
+ * seen from outside, with the usual orientations:
+ *
+ *  - U, seen from above, has F at its bottom
+ *  - D, seen from below, has F at its top
+ *  - R, F, L, B have U at their top
+ *
+ * Each facelet holds the face it belongs to when solved. Memory is 6 N^2 bytes, and a turn
+ * moves 4 N facelets (plus the N^2 of the face for an outer layer).
+ */
+class FaceletCube {
+public:
+    int size;
+    std::vector<uint8_t> facelets;
+
+    FaceletCube(int _size = 3) : size(_size), facelets(6 * _size * _size) {
+        for (int f = 0; f < 6; f++)
+            for (int i = 0; i < size * size; i++)
+                facelets[f * size * size + i] = f;
+        build_cycles();
+    }
+
+    /// @return Returns the index of a facelet in `facelets`
+    int index(Face f, int row, int col) const { return (f * size + row) * size + col; }
+
+    uint8_t at(Face f, int row, int col) const { return facelets[index(f, row, col)]; }
+
+    bool is_solved() const {
+        for (int f = 0; f < 6; f++)
+            for (int i = 0; i < size * size; i++)
+                if (facelets[f * size * size + i] != f) return false;
+        return true;
+    }
+
+    /**
+     * Turns one layer clockwise (seen from outside `face`), `power` quarter turns.
+     */
+    void turn(Face face, int layer, int power) { permute(facelets, face, layer, power); }
+
+    void turn(const LayerMove& m) { turn(m.face, m.layer, m.power); }
+
+    /// Applies a move of the 3x3x3 notation (outer layer)
+    void turn(Move m) { turn(move_face(m), 0, move_power(m)); }
+
+    /**
+     * Moves the entries of any array of 6 N^2 values like a turn moves the facelets (e.g. to
+     * follow each piece with its own label rather than with its color).
+     */
+    template <class T>
+    void permute(std::vector<T>& values, Face face, int layer, int power) const {
+        // The layer of a face is also a layer of the opposite face, turned the other way.
+        // Only U, R and F have their cycles stored.
+        if (face >= FACE_D) {
+            layer = size - 1 - layer;
+            power = 4 - power;
+            face = opposite_face(face);
+        }
+        const std::vector<std::array<int, 4>>& layer_cycles = cycles[face * size + layer];
+        for (int p = 0; p < (power % 4 + 4) % 4; p++) {
+            for (const auto& c: layer_cycles) {
+                T last = values[c[3]];
+                values[c[3]] = values[c[2]];
+                values[c[2]] = values[c[1]];
+                values[c[1]] = values[c[0]];
+                values[c[0]] = last;
+            }
+        }
+    }
+
+    /**
+     * @return Returns the other facelet of the same piece, for a facelet of an edge piece
+     * (-1 for the corners and the centers)
+     */
+    int partner(int index) const { return partners[index]; }
+
+private:
+    /// For the layers of U, R and F: the 4-cycles of facelets of one clockwise quarter turn
+    std::vector<std::vector<std::array<int, 4>>> cycles;
+
+    std::vector<int> partners;
+
+    struct Point { int x, y, z; };
+
+    /// Outward normal, and the directions of the columns and of the rows of each face
+    static Point normal(int f) {
+        static const Point n[6] = {{0, 1, 0}, {1, 0, 0}, {0, 0, 1}, {0, -1, 0}, {-1, 0, 0}, {0, 0, -1}};
+        return n[f];
+    }
+    static Point right(int f) {
+        static const Point r[6] = {{1, 0, 0}, {0, 0, -1}, {1, 0, 0}, {1, 0, 0}, {0, 0, 1}, {-1, 0, 0}};
+        return r[f];
+    }
+    static Point down(int f) {
+        static const Point d[6] = {{0, 0, 1}, {0, -1, 0}, {0, -1, 0}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0}};
+        return d[f];
+    }
+
+    static int dot(Point a, Point b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    /// Clockwise quarter turn around `n`, seen from outside: v -> n (n.v) - n x v
+    static Point rotate(Point v, Point n) {
+        Point c = {n.y * v.z - n.z * v.y, n.z * v.x - n.x * v.z, n.x * v.y - n.y * v.x};
+        int d = dot(n, v);
+        return {n.x * d - c.x, n.y * d - c.y, n.z * d - c.z};
+    }
+
+    static int64_t key(Point p) { return (int64_t(p.x + 1024) << 22) | (int64_t(p.y + 1024) << 11) | (p.z + 1024); }
+
+    /**
+     * Computes the cycles from the geometry: in coordinates doubled so that they are
+     * integers, each facelet is at (center of its cube + its normal).
+     */
+    void build_cycles() {
+        std::vector<Point> position(facelets.size());
+        std::unordered_map<int64_t, int> facelet_at;
+        for (int f = 0; f < 6; f++) {
+            Point n = normal(f), r = right(f), d = down(f);
+            for (int row = 0; row < size; row++) {
+                for (int col = 0; col < size; col++) {
+                    int u = 2 * col - (size - 1), v = 2 * row - (size - 1);
+                    Point p = {n.x * size + r.x * u + d.x * v, n.y * size + r.y * u + d.y * v, n.z * size + r.z * u + d.z * v};
+                    position[index(Face(f), row, col)] = p;
+                    facelet_at[key(p)] = index(Face(f), row, col);
+                }
+            }
+        }
+
+        // The other facelets of a piece are around the center of its cube
+        partners.assign(facelets.size(), -1);
+        for (size_t i = 0; i < facelets.size(); i++) {
+            Point p = position[i], fn = normal(i / (size * size));
+            std::vector<int> others;
+            for (int f = 0; f < 6; f++) {
+                Point n = normal(f);
+                if (f == int(i / (size * size))) continue;
+                auto other = facelet_at.find(key({p.x - fn.x + n.x, p.y - fn.y + n.y, p.z - fn.z + n.z}));
+                if (other != facelet_at.end()) others.push_back(other->second);
+            }
+            if (others.size() == 1) partners[i] = others[0];
+        }
+
+        cycles.assign(3 * size, {});
+        for (int f = 0; f < 3; f++) {
+            Point n = normal(f);
+            for (int layer = 0; layer < size; layer++) {
+                // Depth of the centers of the cubes of this layer, along n
+                int depth = size - 1 - 2 * layer;
+                std::vector<bool> done(facelets.size(), false);
+                for (size_t i = 0; i < facelets.size(); i++) {
+                    Point p = position[i];
+                    Point fn = normal(i / (size * size));
+                    Point center = {p.x - fn.x, p.y - fn.y, p.z - fn.z};
+                    if (dot(center, n) != depth || done[i]) continue;
+
+                    std::array<int, 4> c;
+                    for (int k = 0; k < 4; k++) {
+                        c[k] = facelet_at[key(p)];
+                        done[c[k]] = true;
+                        p = rotate(p, n);
+                    }
+                    cycles[f * size + layer].push_back(c);
+                }
+            }
+        }
+    }
+};
+
+#endif
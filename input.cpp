@@ -0,0 +1,169 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Keyboard input of the game, from the keyboard or from a recording.
+ *
+ * The game receives the keys as events: each tick, the events sent by the window since the
+ * last tick (and recorded, if asked), or the events of a recording for that tick. The keys
+ * held are kept in a `KeyboardState`. The events are replayed by tick number, not by time: a
+ * replay does exactly the work of the session recorded, however fast it runs. The moves found in the
+ * background are events too (see `KeyboardState::SOLUTION_KEY`).
+ */
+
+/// A key or a mouse button pressed or released
+struct KeyEvent {
+    /// Tick of the game at which the change was seen
+    uint64_t tick;
+    /// Seconds since the start of the recording
+    double time;
+    int32_t key;
+    int32_t pressed;
+    /// Position of the pointer: from (-1, -1) at the bottom left of the window to (1, 1) at
+    /// the top right
+    float x;
+    float y;
+};
+static_assert(sizeof(KeyEvent) == 32, "the events are written as raw bytes");
+
+/// First bytes of a recording, followed by the events
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    /// Size of the cube the recording starts with (a new one)
+    uint32_t size;
+    /// Seed of the scrambler, so that the scrambles are the same
+    uint64_t seed;
+    uint64_t events;
+};
+
+/**
+ * Which keys are down. The keys are numbered like GLFW's, and so are the mouse buttons, from
+ * 0 to 7 (no key has these numbers).
+ */
+class KeyboardState {
+public:
+    static constexpr int KEYS = 512;
+
+    /**
+     * Not keys of the keyboard: the moves found in the background (by a solve or a
+     * scramble), at the tick they reach the game. Each move is a `SOLUTION_MOVE_KEY` event,
+     * whose `pressed` holds the move; `SOLUTION_KEY` pressed then plays the moves received
+     * as a solution, and `SOLUTION_KEY` released ends the job. A replay gets the same moves
+     * at the same ticks, without solving anything.
+     */
+    static constexpr int SOLUTION_KEY = KEYS - 1;
+    static constexpr int SOLUTION_MOVE_KEY = KEYS - 2;
+
+    bool is_pressed(int key) const { return key >= 0 && key < KEYS && keys[key]; }
+
+    void set(int key, bool pressed) {
+        if (key >= 0 && key < KEYS) keys[key] = pressed;
+    }
+
+private:
+    std::array<bool, KEYS> keys = {};
+};
+
+/**
+ * Writes the key events of a session. The events stay in memory (a few bytes per key
+ * pressed), and the file is written when it is closed.
+ */
+class InputRecorder {
+public:
+    InputRecorder() = default;
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+    ~InputRecorder() { close(); }
+
+    /// @return Returns false if the file cannot be created
+    bool open(const std::string& path, int size, uint64_t seed) {
+        close();
+        file = std::fopen(path.c_str(), "wb");
+        events.clear();
+        cube_size = size;
+        scrambler_seed = seed;
+        return file != nullptr;
+    }
+
+    bool is_open() const { return file != nullptr; }
+
+    void record(const KeyEvent& e) { events.push_back(e); }
+
+    /// @return Returns false if the file could not be written
+    bool close() {
+        if (!file) return false;
+        RecordingHeader h = {};
+        std::memcpy(h.magic, RECORDING_MAGIC, sizeof(h.magic));
+        h.version = RECORDING_VERSION;
+        h.size = cube_size;
+        h.seed = scrambler_seed;
+        h.events = events.size();
+        bool ok = std::fwrite(&h, sizeof(h), 1, file) == 1
+            && std::fwrite(events.data(), sizeof(KeyEvent), events.size(), file) == events.size();
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+    static constexpr char RECORDING_MAGIC[8] = {'R', 'C', 'K', 'E', 'Y', 'S', 0, 0};
+    /// The files of any other version are not read
+    static constexpr uint32_t RECORDING_VERSION = 1;
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<KeyEvent> events;
+    int cube_size = 3;
+    uint64_t scrambler_seed = 0;
+};
+
+/**
+ * Plays the events of a recording, tick by tick.
+ */
+class InputReplay {
+public:
+    /// @return Returns false if the file is missing or is not a recording
+    bool load(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1
+            && std::memcmp(header.magic, InputRecorder::RECORDING_MAGIC, sizeof(header.magic)) == 0
+            && header.version == InputRecorder::RECORDING_VERSION;
+        if (ok) {
+            events.resize(header.events);
+            ok = std::fread(events.data(), sizeof(KeyEvent), events.size(), file) == events.size();
+        }
+        std::fclose(file);
+        next = 0;
+        return ok;
+    }
+
+    int size() const { return header.size; }
+    uint64_t seed() const { return header.seed; }
+
+    /**
+     * Sends the events of a tick, in order, to `handle(const KeyEvent&)` (the ticks must be
+     * played in order).
+     */
+    template <typename Handler>
+    void play(uint64_t tick, Handler&& handle) {
+        for (; next < events.size() && events[next].tick <= tick; next++) handle(events[next]);
+    }
+
+    /// @return Returns true once all the events are played
+    bool is_finished() const { return next == events.size(); }
+
+private:
+    RecordingHeader header = {};
+    std::vector<KeyEvent> events;
+    size_t next = 0;
+};
+
+#endif
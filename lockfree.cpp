@@ -0,0 +1,85 @@
+#ifndef LOCKFREE_H
+#define LOCKFREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Hands the latest value from one thread (the writer) to another (the reader), without
+ * locks and without copies: there are three values, one being written, one being read, and
+ * the last one published between them.
+ *
+ * The writer fills `back()` and calls `publish()`, as often as it wants; the reader calls
+ * `update()`, and reads `front()` until its next update. The reader always gets the latest
+ * value published, and the values it skips are simply overwritten.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    /// The value being written (writer only)
+    T& back() { return buffers[back_index]; }
+
+    /// Makes the value written the latest one (writer only)
+    void publish() {
+        back_index = middle.exchange(back_index | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /**
+     * Takes the latest value published, if it is newer than `front()` (reader only)
+     * @return Returns false if nothing was published since the last update
+     */
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front_index = middle.exchange(front_index, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    /// The value being read (reader only)
+    const T& front() const { return buffers[front_index]; }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    T buffers[3];
+    uint8_t back_index = 0;
+    std::atomic<uint8_t> middle{1};
+    uint8_t front_index = 2;
+};
+
+/**
+ * A queue of fixed capacity between one producer thread and one consumer thread, without
+ * locks. `CAPACITY` must be a power of 2.
+ */
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "the capacity must be a power of 2");
+
+public:
+    /// @return Returns false, and drops the value, if the queue is full (producer only)
+    bool push(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) return false;
+        values[t & (CAPACITY - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @return Returns false if the queue is empty (consumer only)
+    bool pop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        value = values[h & (CAPACITY - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T values[CAPACITY];
+    // On separate cache lines, as each is written by its own thread
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+#endif
@@ -1,6 +1,15 @@
 #include <iostream>
 #include <filesystem>
 #include <string>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <fstream>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -13,220 +22,1093 @@
 
 #include "shader.cpp"
 #include "rubicscube.cpp"
+#include "pocket_solver.cpp"
+#include "reduction_solver.cpp"
+#include "scrambler.cpp"
+#include "solve_job.cpp"
+#include "session.cpp"
+#include "input.cpp"
+#include "capture.cpp"
+#include "lockfree.cpp"
+#include "picking.cpp"
+#ifndef __EMSCRIPTEN__
+#include "offscreen.cpp"
+#include <unistd.h>
+#endif
 
 // Global variables that hold the state of the game
 RubicsCube game;
 RotationManager rotation_manager(&game);
+ReductionSolver solver;
+PocketCubeSolver pocket_solver;
+std::unique_ptr<OptimalSolver> optimal_solver;
+Scrambler scrambler;
+
+// Solves and scrambles run in the background, the game only polls them
+SolverPool solver_pool;
+std::shared_ptr<SolveJob> solve_job;
+// What runs in the background, if anything. Its moves reach the game as events (see
+// `KeyboardState::SOLUTION_KEY`), from `solve_job`, or from the recording in a replay (which
+// runs no job)
+enum class Background { NONE, SOLVE, SCRAMBLE } background = Background::NONE;
+bool replaying = false;
+// The stickers solved by the job: its solution is dropped if the cube was turned meanwhile
+std::vector<uint8_t> solve_start;
+// The solution being played, as it was queued, and the moves of the next one, as they come
+std::vector<LayerMove> solution_queued, solution_received;
+// The number of solutions of `solve_job` already received
+unsigned solutions_received = 0;
 
 // Camera state
 glm::vec3 cameraPos   = glm::vec3(0.0f, 0.0f,  5.0f);
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
 glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f,  0.0f);
 
-// Key states for the game
-bool keyMajPressed = false;
-bool keyFPressed = false;
-bool keyRPressed = false;
-bool keyUPressed = false;
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
 
-bool key1_pressed = false;
-bool key2_pressed = false;
-bool key3_pressed = false;
-bool key4_pressed = false;
-bool key5_pressed = false;
-bool key6_pressed = false;
+/// The projection of the camera, for a cube of the given size (far enough to zoom out)
+glm::mat4 cameraProjection(int size, float aspect)
+{
+    return glm::perspective(glm::radians(70.0f), aspect, 0.1f, 40.0f + 20.0f * size);
+}
 
-unsigned int yellow, red, white, blue, orange, green, none;
+// Keys held, from the keyboard or from a recording (on the game thread)
+KeyboardState keyboard;
+// The sticker under the pointer when the left mouse button was pressed, if any
+Pick pointerPick;
 
-unsigned int color_to_code(Color c) {
-    switch (c)
-    {
-    case Color::YELLOW: return yellow;
-    case Color::GREEN: return green;
-    case Color::RED: return red;
-    case Color::BLUE: return blue;
-    case Color::ORANGE: return orange;
-    case Color::WHITE: return white;
-    case Color::NONE: return none;
+/// @return Returns moves of the 3x3x3 notation as turns of the outer layers
+std::vector<LayerMove> layerMoves(const std::vector<Move>& moves)
+{
+    std::vector<LayerMove> layer_moves;
+    for (Move m: moves) layer_moves.push_back({move_face(m), 0, uint8_t(move_power(m))});
+    return layer_moves;
+}
+
+/**
+ * Starts a solve or a scramble of the cube as it is, in the background. A replay runs no
+ * task: the moves come from its recording.
+ */
+void startBackground(Background kind, SolverPool::Task task)
+{
+    background = kind;
+    solve_start = game.facelets.facelets;
+    solution_queued.clear();
+    solution_received.clear();
+    solutions_received = 0;
+    if (!replaying) solve_job = solver_pool.submit(std::move(task));
+}
+
+/**
+ * Solves the cube in the background. Each solution found is played as soon as it is found,
+ * and ENTER again stops the search.
+ *
+ * `optimal` also looks for a shortest solution of a 3x3x3 (with the pattern databases of
+ * `PdbGen`, in the current directory, if there are), after a quick first one.
+ */
+void startSolve(bool optimal)
+{
+    FaceletCube cube = game.facelets;
+    startBackground(Background::SOLVE, [cube, optimal](SolveJob& job) {
+        std::vector<LayerMove> solution;
+        std::vector<Move> moves;
+        // The 2x2x2 is solved optimally (its table is generated at the first use)
+        if (cube.size == 2 && (pocket_solver.is_loaded() || pocket_solver.load())) {
+            if (pocket_solver.solve(cube, moves)) job.offer(layerMoves(moves));
+            return;
+        }
+        if (!solver.solve(cube, solution)) return;
+        job.offer(solution);
+
+        // A shortest solution, if the centers are in place (a 3x3x3 state)
+        CubeState start;
+        if (!optimal || cube.size != 3 || !CubeState::from_facelets(cube.facelets.data(), start)) return;
+        if (!optimal_solver) {
+            // Kept for the next solves, with its pattern databases mapped
+            optimal_solver.reset(new OptimalSolver());
+            optimal_solver->load(".");
+        }
+        optimal_solver->progress = &job.progress;
+        if (optimal_solver->solve(start, moves)) job.offer(layerMoves(moves));
+        optimal_solver->progress = nullptr;
+    });
+}
+
+/**
+ * Scrambles the cube in the background: a random state on the 2x2x2 and the 3x3x3 (whose
+ * tables are built at the first scramble), random turns on the bigger cubes. Does nothing
+ * while a move, a solve or another scramble is in progress.
+ */
+void scramble()
+{
+    if (!rotation_manager.is_free() || background != Background::NONE) return;
+    int size = game.size;
+    startBackground(Background::SCRAMBLE, [size](SolveJob& job) {
+        if (size == 3)
+            job.offer(layerMoves(scrambler.scramble(TwoPhaseSolver::instance())));
+        else if (size == 2 && (pocket_solver.is_loaded() || pocket_solver.load()))
+            job.offer(layerMoves(scrambler.scramble(pocket_solver)));
+        else if (size > 3)
+            job.offer(scrambler.random_moves(size, 20 * size));
+    });
+}
+
+/**
+ * Receives the moves found in the background (see `KeyboardState::SOLUTION_KEY`): a new
+ * solution when `pressed`, made of the moves received since the last one, or the end of the
+ * job.
+ *
+ * The first solution is played if the cube is still as the job found it. A shorter one
+ * then replaces the moves of the previous one that are still waiting: the moves already
+ * played are undone, then the new solution is played, if that makes fewer moves.
+ */
+void receiveSolution(bool pressed)
+{
+    std::vector<LayerMove> solution = simplify_layer_moves(solution_received, game.size);
+    solution_received.clear();
+    if (!pressed) {
+        background = Background::NONE;
+        solve_job.reset();
+        solution_queued.clear();
+        return;
     }
-    return 0;
+    if (solution_queued.empty()) {
+        if (rotation_manager.is_free() && game.facelets.facelets == solve_start) {
+            rotation_manager.queue_moves(solution);
+            solution_queued = solution;
+        }
+        return;
+    }
+    size_t waiting = rotation_manager.waiting_moves(), played = solution_queued.size() - waiting;
+    std::vector<LayerMove> moves;
+    for (size_t i = played; i-- > 0;) moves.push_back(solution_queued[i].inverse());
+    moves.insert(moves.end(), solution.begin(), solution.end());
+    moves = simplify_layer_moves(moves, game.size);
+    if (moves.size() >= waiting) return;
+    rotation_manager.replace_waiting_moves(moves);
+    solution_queued.resize(played);
+    solution_queued.insert(solution_queued.end(), moves.begin(), moves.end());
+}
+
+/// A move in the `pressed` of a `SOLUTION_MOVE_KEY` event: its face, layer and power, a byte each
+int32_t packMove(const LayerMove& m)
+{
+    return int32_t(m.face) | int32_t(m.layer) << 8 | int32_t(m.power) << 16;
+}
+
+/// @return Returns false if the value is not a move of the cube of the game
+bool unpackMove(int32_t value, LayerMove& m)
+{
+    m = {Face(value & 0xFF), uint8_t(value >> 8), uint8_t(value >> 16)};
+    return value >= 0 && value < (1 << 24) && m.face <= FACE_B && m.layer < game.size && m.power >= 1 && m.power <= 3;
+}
+
+/**
+ * Sends what the job found since the last tick to the game, as events for `handle` (in a
+ * session, not in a replay): a `SOLUTION_MOVE_KEY` per move of a new solution followed by
+ * `SOLUTION_KEY` pressed, and `SOLUTION_KEY` released once the job is over.
+ */
+template <typename Handler>
+void receiveJob(uint64_t tick, double time, Handler&& handle)
+{
+    if (!solve_job) return;
+    // Once the job is done, all its solutions are offered
+    bool done = solve_job->is_done();
+    std::vector<LayerMove> solution;
+    unsigned offers = solve_job->best_solution(solution);
+    if (offers > solutions_received) {
+        solutions_received = offers;
+        for (const LayerMove& m: solution)
+            handle(KeyEvent{tick, time, KeyboardState::SOLUTION_MOVE_KEY, packMove(m), 0.0f, 0.0f});
+        handle(KeyEvent{tick, time, KeyboardState::SOLUTION_KEY, 1, 0.0f, 0.0f});
+    }
+    if (done) handle(KeyEvent{tick, time, KeyboardState::SOLUTION_KEY, 0, 0.0f, 0.0f});
+}
+
+/**
+ * Turns a face of the selected layer, backward with SHIFT (if no move is in progress)
+ */
+void turn(Motion motion)
+{
+    if (rotation_manager.is_free())
+        rotation_manager.start_motion(motion, !keyboard.is_pressed(GLFW_KEY_LEFT_SHIFT));
+}
+
+/// What a key does when it is pressed (`window` is null when there is none)
+struct KeyAction {
+    int key;
+    void (*press)(GLFWwindow *window);
+};
+
+const KeyAction KEYMAP[] = {
+    {GLFW_KEY_ESCAPE, [](GLFWwindow *window) { if (window) glfwSetWindowShouldClose(window, true); }},
+
+    // Game actions: F, R, U (backward with SHIFT)
+    {GLFW_KEY_F, [](GLFWwindow *) { turn(Motion::F); }},
+    {GLFW_KEY_R, [](GLFWwindow *) { turn(Motion::R); }},
+    {GLFW_KEY_U, [](GLFWwindow *) { turn(Motion::U); }},
+
+    // Game actions: 1,2,3,4,5,6 (to change colors)
+    {GLFW_KEY_1, [](GLFWwindow *) { game.set_main_color(Color::WHITE); }},
+    {GLFW_KEY_2, [](GLFWwindow *) { game.set_main_color(Color::BLUE); }},
+    {GLFW_KEY_3, [](GLFWwindow *) { game.set_main_color(Color::YELLOW); }},
+    {GLFW_KEY_4, [](GLFWwindow *) { game.set_main_color(Color::GREEN); }},
+    {GLFW_KEY_5, [](GLFWwindow *) { game.set_main_color(Color::RED); }},
+    {GLFW_KEY_6, [](GLFWwindow *) { game.set_main_color(Color::ORANGE); }},
+
+    // Game actions: Z,X (to select a shallower or a deeper layer, on big cubes)
+    {GLFW_KEY_Z, [](GLFWwindow *) { if (game.current_layer > 0) game.current_layer--; }},
+    {GLFW_KEY_X, [](GLFWwindow *) { if (game.current_layer < game.size - 1) game.current_layer++; }},
+
+    // Game actions: ENTER (to solve the cube, or to stop the solve in progress),
+    // SHIFT + ENTER (to look for a shortest solution of a 3x3x3)
+    {GLFW_KEY_ENTER, [](GLFWwindow *) {
+        if (background == Background::SOLVE) {
+            if (solve_job) solve_job->cancel();
+        } else if (background == Background::NONE && rotation_manager.is_free()) {
+            startSolve(keyboard.is_pressed(GLFW_KEY_LEFT_SHIFT));
+        }
+    }},
+
+    // Game actions: SPACE (to scramble the cube)
+    {GLFW_KEY_SPACE, [](GLFWwindow *) { scramble(); }},
+
+    // Game actions: BACKSPACE (to undo, or redo with SHIFT), HOME and END (to go back to
+    // the start, or forward to the last turn, at once)
+    {GLFW_KEY_BACKSPACE, [](GLFWwindow *) {
+        if (keyboard.is_pressed(GLFW_KEY_LEFT_SHIFT)) rotation_manager.redo();
+        else rotation_manager.undo();
+    }},
+    {GLFW_KEY_HOME, [](GLFWwindow *) { rotation_manager.jump_to(0); }},
+    {GLFW_KEY_END, [](GLFWwindow *) { rotation_manager.jump_to(game.journal.moves().size()); }},
+};
+
+/// The keys read while they are held, each tick (see `processInput`)
+const int HELD_KEYS[] = {
+    GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_K, GLFW_KEY_J, GLFW_KEY_LEFT_SHIFT,
+};
+
+/// @return Returns true for the keys the game reads (the others are not even recorded)
+bool isGameKey(int key)
+{
+    for (const KeyAction& action: KEYMAP)
+        if (action.key == key) return true;
+    return std::find(std::begin(HELD_KEYS), std::end(HELD_KEYS), key) != std::end(HELD_KEYS);
+}
+
+/**
+ * The left mouse button, on the game thread: a click on a sticker selects its face (like the
+ * keys 1 to 6), and a drag from a sticker turns its layer that follows the pointer. The
+ * stickers are picked on the cube of the game, as it is at the tick of the event.
+ */
+void dragPointer(const KeyEvent& e)
+{
+    glm::mat4 view = glm::lookAt(cameraPos, vec3(0., 0., 0.), cameraUp);
+    Ray ray = screen_ray(e.x, e.y, view, cameraProjection(game.size, (float)SCR_WIDTH / (float)SCR_HEIGHT));
+    if (e.pressed) {
+        if (!rotation_manager.is_free() || !pick(game, ray, pointerPick)) pointerPick = Pick();
+        return;
+    }
+    Pick from = pointerPick;
+    pointerPick = Pick();
+    if (from.face == Color::NONE || !rotation_manager.is_free()) return;
+    LayerMove move;
+    if (drag_turn(game, from, ray, move)) rotation_manager.queue_moves(std::vector<LayerMove>{move});
+    else game.set_main_color(from.face);
 }
 
 /**
- * Process all inputs for the rubicscube solver
+ * Applies a key event, on the game thread: the key is held until it is released, and its
+ * action (if any) is done when it is pressed, even if it is released within the same tick.
  */
-void processInput(GLFWwindow *window)
+void handleKey(const KeyEvent& e, GLFWwindow *window)
+{
+    LayerMove move;
+    if (e.key == KeyboardState::SOLUTION_MOVE_KEY) {
+        if (unpackMove(e.pressed, move)) solution_received.push_back(move);
+        return;
+    }
+    if (e.key == KeyboardState::SOLUTION_KEY) return receiveSolution(e.pressed != 0);
+    keyboard.set(e.key, e.pressed != 0);
+    if (e.key == GLFW_MOUSE_BUTTON_LEFT) return dragPointer(e);
+    if (!e.pressed) return;
+    for (const KeyAction& action: KEYMAP)
+        if (action.key == e.key) action.press(window);
+}
+
+// Key events, from the window thread to the game thread
+SpscQueue<KeyEvent, 256> keyEvents;
+// The key events that did not fit in `keyEvents` while the game thread was late, in order
+// (window thread)
+std::deque<KeyEvent> pendingKeyEvents;
+
+/// Moves the pending key events to the game, as many as fit (window thread)
+void flushKeyEvents()
+{
+    while (!pendingKeyEvents.empty() && keyEvents.push(pendingKeyEvents.front()))
+        pendingKeyEvents.pop_front();
+}
+
+/// Sends a key event to the game after the pending ones: none is ever dropped (window thread)
+void sendKeyEvent(const KeyEvent& e)
+{
+    flushKeyEvents();
+    if (!pendingKeyEvents.empty() || !keyEvents.push(e)) pendingKeyEvents.push_back(e);
+}
+
+/// @return Returns an event of a key at this time, with the position of the pointer (window thread)
+KeyEvent pointerEvent(GLFWwindow *window, int key, bool pressed)
 {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
+    double x, y;
+    int width, height;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &width, &height);
+    width = std::max(width, 1);
+    height = std::max(height, 1);
+    return {0, glfwGetTime(), key, pressed, float(2 * x / width - 1), float(1 - 2 * y / height)};
+}
+
+// glfw: whenever a key is pressed or released, this callback sends it to the game (on the
+// window thread, in `glfwPollEvents`)
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+    if (action == GLFW_REPEAT || !isGameKey(key)) return;
+    sendKeyEvent(pointerEvent(window, key, action == GLFW_PRESS));
+}
 
-    const float cameraSpeed = 0.15f; // adjust accordingly
+// glfw: whenever a mouse button is pressed or released, this callback sends the left one to
+// the game, with the position of the pointer
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
+{
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action == GLFW_REPEAT) return;
+    // A minimized window has no pointer to pick with
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    if (width <= 0 || height <= 0) return;
+    sendKeyEvent(pointerEvent(window, button, action == GLFW_PRESS));
+}
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+/**
+ * Moves the camera with the keys held, each tick
+ */
+void processInput()
+{
+    const float cameraSpeed = 0.05f * game.size; // adjust accordingly
+
+    if (keyboard.is_pressed(GLFW_KEY_W))
         cameraPos -= 0.1f * cameraSpeed * cameraPos;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (keyboard.is_pressed(GLFW_KEY_S))
         cameraPos += 0.1f * cameraSpeed * cameraPos;
         
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (keyboard.is_pressed(GLFW_KEY_A))
         cameraPos += glm::normalize(glm::cross(cameraPos, cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (keyboard.is_pressed(GLFW_KEY_D))
         cameraPos -= glm::normalize(glm::cross(cameraPos, cameraUp)) * cameraSpeed;
 
     // ups and downs
-    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS)
+    if (keyboard.is_pressed(GLFW_KEY_K))
         cameraPos += cameraUp * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS)
+    if (keyboard.is_pressed(GLFW_KEY_J))
         cameraPos -= cameraUp * cameraSpeed;
+}
 
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+void framebuffer_size_callback(GLFWwindow *window, int width, int height)
+{
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+    glViewport(0, 0, width, height);
+}
 
-    // Detect if maj is pressed (to do backward motion)
-
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) {
-        if (!keyMajPressed) keyMajPressed = true;
-    } else if (keyMajPressed) {
-        keyMajPressed = false;
+/**
+ * A function that loads the textures of all the colors in a single texture array.
+ * The layer of a color is its value in `Color` (NONE being the "selected" texture).
+ * @return Returns the average color of the "selected" texture, which lightens the main face
+ */
+glm::vec4 load_gl_color_array(unsigned int& id) {
+    const char* paths[7] = {
+        "/home/arthur/dev/cpp/tuto1/resources/white.png",
+        "/home/arthur/dev/cpp/tuto1/resources/red.png",
+        "/home/arthur/dev/cpp/tuto1/resources/yellow.png",
+        "/home/arthur/dev/cpp/tuto1/resources/orange.png",
+        "/home/arthur/dev/cpp/tuto1/resources/green.png",
+        "/home/arthur/dev/cpp/tuto1/resources/blue.png",
+        "/home/arthur/dev/cpp/tuto1/resources/selected.png",
+    };
+    const int size = 32;
+    glm::vec4 selected(0.0f);
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, size, size, 7, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    stbi_set_flip_vertically_on_load(true);
+    for (int layer = 0; layer < 7; layer++) {
+        int width, height, nrChannels;
+        unsigned char *data = stbi_load(paths[layer], &width, &height, &nrChannels, 4);
+        if (data && width == size && height == size) {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            if (layer == Color::NONE) {
+                for (int i = 0; i < size * size * 4; i++) selected[i % 4] += data[i];
+                selected /= 255.0f * size * size;
+            }
+        } else
+            std::cerr << "Failed to load texture " << paths[layer] << std::endl;
+        stbi_image_free(data);
     }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    return selected;
+}
 
-    // Game actions: F, R, U
+/**
+ * What the instanced renderer needs to know about a cube
+ */
+struct CubeInstance {
+    glm::mat4 model;
+    // The colors of the front, right and top faces, and whether the cube is highlighted
+    uint8_t colors[4];
+};
 
-    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) {
-        if (!keyFPressed) {
-            keyFPressed = true;
-            if (rotation_manager.is_free()) {
-                rotation_manager.start_motion(Motion::F, !keyMajPressed);
+/**
+ * A face of a cube that can be seen: only these are drawn
+ */
+struct StickerInstance {
+    glm::mat4 model;
+    // The face of the cube (as numbered in `Scene`), the layer of its color, and whether the
+    // cube is highlighted
+    uint8_t sticker[4];
+};
+
+/**
+ * What is drawn in a frame: the stickers and the camera, as the game left them at the end of
+ * a tick. The render thread only reads snapshots, never the game itself.
+ */
+struct Snapshot {
+    int size = 0;
+    glm::vec3 camera_pos;
+    glm::vec3 camera_up;
+    std::vector<StickerInstance> stickers;
+    // The distance of each cube of the game to the camera (squared), and its index, from the closest
+    std::vector<std::pair<float, uint32_t>> order;
+    // The solve in progress, if any
+    bool solving = false;
+    int solve_depth = 0;
+    uint64_t solve_nodes = 0;
+};
+
+/**
+ * Copies the game into a snapshot, reusing its memory.
+ *
+ * Only the faces that can be seen are kept: the ones outside the rubicscube, and during a
+ * turn, the ones between the layer turned and the rest (all the faces of the cubes turned, and
+ * the faces of their neighbors toward them). They are sorted from the closest cube to the
+ * camera to the farthest: the depth test then rejects the hidden ones before their fragments
+ * are shaded.
+ */
+void takeSnapshot(Snapshot& snapshot)
+{
+    // The faces of a cube, numbered as in `Scene`, and their colors (front, right and top)
+    static const glm::vec3 FACE_NORMALS[6] = {
+        glm::vec3(0, 0, -1), glm::vec3(0, 0, 1), glm::vec3(-1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(0, -1, 0), glm::vec3(0, 1, 0),
+    };
+    static const int FACE_COLORS[6] = {-1, 0, -1, 1, 2, 2};
+
+    Color colors[3];
+    snapshot.size = game.size;
+    snapshot.camera_pos = cameraPos;
+    snapshot.camera_up = cameraUp;
+    snapshot.solving = background == Background::SOLVE;
+    snapshot.solve_depth = solve_job ? solve_job->progress.depth.load() : 0;
+    snapshot.solve_nodes = solve_job ? solve_job->progress.nodes.load() : 0;
+
+    snapshot.order.resize(game.cubes.size());
+    for (size_t i = 0; i < game.cubes.size(); i++) {
+        glm::vec3 d = game.cubes[i].position() - cameraPos;
+        snapshot.order[i] = {glm::dot(d, d), uint32_t(i)};
+    }
+    std::sort(snapshot.order.begin(), snapshot.order.end());
+
+    const float outside = game.half_size() + 0.25f;
+    snapshot.stickers.clear();
+    for (const auto& o: snapshot.order) {
+        const Cube& cube = game.cubes[o.second];
+        cube.fillColors(colors);
+        glm::vec3 position = cube.position();
+        bool turning = rotation_manager.is_turning(position);
+        uint8_t selected = game.is_cube_on_selected_face(cube);
+        for (int f = 0; f < 6; f++) {
+            // The face is hidden by the cube next to it, if there is one and it is not turning
+            if (!turning) {
+                glm::vec3 next = position + glm::mat3(cube.transform) * FACE_NORMALS[f];
+                bool inside = std::abs(next.x) < outside && std::abs(next.y) < outside && std::abs(next.z) < outside;
+                if (inside && !rotation_manager.is_turning(next)) continue;
             }
+            Color color = Color::NONE;
+            if (FACE_COLORS[f] >= 0) color = colors[FACE_COLORS[f]];
+            snapshot.stickers.push_back({cube.transform, {uint8_t(f), uint8_t(Color::Value(color)), selected, 0}});
         }
-    } else if (keyFPressed) {
-        keyFPressed = false;
-    }
-    
-    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
-        if (!keyRPressed) {
-            keyRPressed = true;
-            if (rotation_manager.is_free()) {
-                rotation_manager.start_motion(Motion::R, !keyMajPressed);
-            }
+    }
+}
+
+/**
+ * What is drawn: the buffers, the textures and the shaders of the cubes. Needs a current
+ * OpenGL context (of a window, or offscreen), and draws the cubes of `game` as they are.
+ */
+class Scene {
+public:
+    Scene()
+        : instancedShader("/home/arthur/dev/cpp/tuto1/shader_instanced_vert.glsl", "/home/arthur/dev/cpp/tuto1/shader_instanced_frag.glsl"),
+          stickerShader("/home/arthur/dev/cpp/tuto1/shader_sticker_vert.glsl", "/home/arthur/dev/cpp/tuto1/shader_sticker_frag.glsl")
+    {
+        // set up vertex data (and buffer(s)) and configure vertex attributes
+        // ------------------------------------------------------------------
+
+        /*
+         * Faces are each assigned to a number as defined below
+
+                Back   = 0
+                Front  = 1
+                Left   = 2
+                Right  = 3
+                Bottom = 4
+                Top    = 5 
+
+         */
+        float vertices[] = {
+            -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 0.0f,
+            0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f,
+            0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
+            -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
+
+            -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f,
+            0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 1.0f,
+            0.5f, 0.5f, 0.5f, 1.0f, 1.0f, 1.0f,
+            -0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 1.0f,
+
+            -0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 2.0f,
+            -0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 2.0f,
+            -0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 2.0f,
+            -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 2.0f,
+
+            0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 3.0f,
+            0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 3.0f,
+            0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 3.0f,
+            0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 3.0f,
+
+            -0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 4.0f,
+            0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 4.0f,
+            0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 4.0f,
+            -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 4.0f,
+
+            -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 5.0f,
+            0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 5.0f,
+            0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 5.0f,
+            -0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 5.0f
+            };
+
+        // Each face is 2 triangles of its 4 corners, counter-clockwise seen from outside the
+        // cube: the faces seen from behind are culled
+        unsigned char indices[] = {
+            0, 2, 1, 2, 0, 3,
+            4, 5, 6, 6, 7, 4,
+            8, 9, 10, 10, 11, 8,
+            12, 14, 13, 14, 12, 15,
+            16, 17, 18, 18, 19, 16,
+            20, 22, 21, 22, 20, 23,
+        };
+
+        // Setup VBO, VAO and EBO
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+        // position attribute
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(0);
+
+        // texture coord attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        // All the colors are in one texture array, for all the shaders
+        // ----------------------------------------------------------------
+        glm::vec4 highlightColor = load_gl_color_array(colorArray);
+        glActiveTexture(GL_TEXTURE7);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, colorArray);
+
+        // Instanced rendering, for the thumbnails and the stickers
+        {
+            instancedShader.use();
+            instancedShader.setInt("colors", 7);
+            instancedShader.setVec4("highlightColor", highlightColor);
+
+            // Per-instance attributes: the model matrix (4 columns) and the colors
+            glBindVertexArray(VAO);
+            glGenBuffers(1, &instanceVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            reserve_instances(game.cubes.size());
+            set_instance_attributes(sizeof(CubeInstance), offsetof(CubeInstance, colors));
+
+            // The stickers have no vertex attributes (their corners are in the shader), only
+            // the per-instance ones: the model matrix and the sticker
+            stickerShader.use();
+            stickerShader.setInt("colors", 7);
+            stickerShader.setVec4("highlightColor", highlightColor);
+            glGenVertexArrays(1, &stickerVAO);
+            glBindVertexArray(stickerVAO);
+            glGenBuffers(1, &stickerVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, stickerVBO);
+            reserve_stickers(game.cubes.size() * 3);
+            set_instance_attributes(sizeof(StickerInstance), offsetof(StickerInstance, sticker));
         }
-    } else if (keyRPressed) {
-        keyRPressed = false;
+
+        // Activate depth buffer, and only draw the faces of the cubes turned toward the camera
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+    }
+
+    ~Scene() {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteVertexArrays(1, &stickerVAO);
+        glDeleteBuffers(1, &stickerVBO);
     }
 
-    if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS) {
-        if (!keyUPressed) {
-            keyUPressed = true;
-            if (rotation_manager.is_free()) {
-                rotation_manager.start_motion(Motion::U, !keyMajPressed);
+    /// Draws a snapshot, for a viewport of the given aspect ratio (width / height)
+    void render(const Snapshot& snapshot, float aspect) {
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Setup the camera
+        glm::mat4 view = glm::lookAt(snapshot.camera_pos, vec3(0., 0., 0.), snapshot.camera_up);
+        glm::mat4 projection = cameraProjection(snapshot.size, aspect);
+
+        // All the stickers in one draw call, whatever the size of the cube
+        reserve_stickers(snapshot.stickers.size());
+        stickerShader.use();
+        stickerShader.setMat4("view", view);
+        stickerShader.setMat4("projection", projection);
+        glBindBuffer(GL_ARRAY_BUFFER, stickerVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, snapshot.stickers.size() * sizeof(StickerInstance), snapshot.stickers.data());
+        glBindVertexArray(stickerVAO);
+        glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, snapshot.stickers.size());
+    }
+
+    /**
+     * Draws one rubicscube per tile of a grid of `columns` x `rows` tiles covering the viewport,
+     * row by row from the top left, all seen from `camera_pos`, in a single draw call.
+     *
+     * The camera and the place of the tile are folded into the model matrix of each cube,
+     * which the instanced shader then draws with an identity view and projection.
+     */
+    void render_tiles(const std::vector<RubicsCube>& rubicscubes, int columns, int rows,
+                      glm::vec3 camera_pos, glm::vec3 camera_up, float tile_aspect) {
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        size_t count = 0;
+        for (const RubicsCube& r: rubicscubes) count += r.cubes.size();
+        reserve_instances(count);
+
+        size_t n = 0;
+        for (size_t t = 0; t < rubicscubes.size(); t++) {
+            const RubicsCube& r = rubicscubes[t];
+            int column = t % columns, row = t / columns;
+            glm::mat4 tile = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f + (2 * column + 1.0f) / columns,
+                                                                       1.0f - (2 * row + 1.0f) / rows, 0.0f));
+            tile = glm::scale(tile, glm::vec3(1.0f / columns, 1.0f / rows, 1.0f));
+            glm::mat4 view = glm::lookAt(camera_pos, vec3(0., 0., 0.), camera_up);
+            glm::mat4 projection = cameraProjection(r.size, tile_aspect);
+            glm::mat4 camera = tile * projection * view;
+            for (const Cube& cube: r.cubes) {
+                cube.fillColors(colors);
+                instances[n].model = camera * cube.transform;
+                instances[n].colors[0] = colors[0];
+                instances[n].colors[1] = colors[1];
+                instances[n].colors[2] = colors[2];
+                instances[n].colors[3] = 0;
+                n++;
             }
         }
-    } else if (keyUPressed) {
-        keyUPressed = false;
+
+        instancedShader.use();
+        instancedShader.setMat4("view", glm::mat4(1.0f));
+        instancedShader.setMat4("projection", glm::mat4(1.0f));
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, n * sizeof(CubeInstance), instances.data());
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0, n);
     }
 
-    // Game actions: 1,2,3,4,5,6 (to change colors)
+private:
+    Shader instancedShader;
+    Shader stickerShader;
+    unsigned int VBO, VAO, EBO;
+    // Instanced rendering, for the thumbnails
+    unsigned int colorArray, instanceVBO;
+    std::vector<CubeInstance> instances;
+    Color colors[3] = {Color::NONE, Color::NONE, Color::NONE};
+    // Instanced rendering of the stickers
+    unsigned int stickerVAO, stickerVBO;
+    size_t sticker_capacity = 0;
 
-    if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) {
-        if (!key1_pressed) {
-            key1_pressed = true;
-            game.set_main_color(Color::WHITE);
+    /**
+     * Sets the per-instance attributes of the buffer bound, in the vertex array bound: the
+     * model matrix (4 columns) at the start of each instance, and 4 bytes at `bytes`.
+     */
+    static void set_instance_attributes(size_t stride, size_t bytes) {
+        for (int i = 0; i < 4; i++) {
+            glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, stride, (void *)(i * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(2 + i);
+            glVertexAttribDivisor(2 + i, 1);
         }
-    } else if (key1_pressed) {
-        key1_pressed = false;
+        glVertexAttribIPointer(6, 4, GL_UNSIGNED_BYTE, stride, (void *)bytes);
+        glEnableVertexAttribArray(6);
+        glVertexAttribDivisor(6, 1);
     }
 
-    if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
-        if (!key2_pressed) {
-            key2_pressed = true;
-            game.set_main_color(Color::BLUE);
-        }
-    } else if (key2_pressed) {
-        key2_pressed = false;
+    /// Makes room for `count` stickers in their instance buffer
+    void reserve_stickers(size_t count) {
+        if (count <= sticker_capacity) return;
+        sticker_capacity = count;
+        glBindBuffer(GL_ARRAY_BUFFER, stickerVBO);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(StickerInstance), NULL, GL_STREAM_DRAW);
     }
 
-    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) {
-        if (!key3_pressed) {
-            key3_pressed = true;
-            game.set_main_color(Color::YELLOW);
-        }
-    } else if (key3_pressed) {
-        key3_pressed = false;
+    /// Makes room for `count` cubes in the instance buffer
+    void reserve_instances(size_t count) {
+        if (count <= instances.size()) return;
+        instances.resize(count);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(CubeInstance), NULL, GL_STREAM_DRAW);
     }
+};
 
-    if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) {
-        if (!key4_pressed) {
-            key4_pressed = true;
-            game.set_main_color(Color::GREEN);
-        }
-    } else if (key4_pressed) {
-        key4_pressed = false;
+using std::cout;
+using std::endl;
+
+/**
+ * Plays a recording without a window: only the game (the inputs and the moves), frame by
+ * frame, as fast as possible.
+ */
+int replayHeadless(InputReplay& replay)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t frame = 0;
+    for (; !replay.is_finished() || !rotation_manager.is_free(); frame++) {
+        replay.play(frame, [](const KeyEvent& e) { handleKey(e, NULL); });
+        processInput();
+        rotation_manager.step();
     }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cout << frame << " frames in " << seconds << " s (" << frame / seconds << " frames / s), "
+         << game.journal.position() << " turns, " << (game.facelets.is_solved() ? "solved" : "not solved") << endl;
+    return 0;
+}
 
-    if (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS) {
-        if (!key5_pressed) {
-            key5_pressed = true;
-            game.set_main_color(Color::RED);
-        }
-    } else if (key5_pressed) {
-        key5_pressed = false;
+/**
+ * The game (the inputs and the moves) on a thread of its own, at a fixed tick rate, so that
+ * neither a slow frame nor a slow move stalls the other.
+ *
+ * Each tick applies the keys received from the window thread (or the events of a recording,
+ * by tick), plays the moves and publishes a snapshot of the cubes for the render thread. A
+ * recording is also written by tick, which keeps it deterministic. A tick rate of 0 runs the
+ * ticks as fast as possible (for a replay).
+ */
+class Simulation {
+public:
+    static constexpr double TICK_RATE = 60;
+
+    TripleBuffer<Snapshot> snapshots;
+
+    Simulation(GLFWwindow* _window, InputRecorder* _recorder, InputReplay* _replay, double tick_rate)
+        : window(_window), recorder(_recorder), replay(_replay),
+          period(tick_rate > 0 ? 1.0 / tick_rate : 0.0) {
+        takeSnapshot(snapshots.back());
+        snapshots.publish();
     }
 
-    if (glfwGetKey(window, GLFW_KEY_6) == GLFW_PRESS) {
-        if (!key6_pressed) {
-            key6_pressed = true;
-            game.set_main_color(Color::ORANGE);
+    ~Simulation() { stop(); }
+
+    void start() { thread = std::thread([this] { run(); }); }
+
+    /// Stops the game at the end of the current tick
+    void stop() {
+        stopping = true;
+        if (thread.joinable()) thread.join();
+    }
+
+    /// @return Returns true once a replay is over
+    bool is_finished() const { return finished; }
+
+    uint64_t ticks() const { return tick; }
+
+private:
+    GLFWwindow* window;
+    InputRecorder* recorder;
+    InputReplay* replay;
+    std::chrono::duration<double> period;
+    std::thread thread;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> finished{false};
+    std::atomic<uint64_t> tick{0};
+
+    void run() {
+        auto start = std::chrono::steady_clock::now(), next = start;
+        for (; !stopping; tick++) {
+            if (replay) {
+                if (replay->is_finished() && rotation_manager.is_free()) break;
+                replay->play(tick, [this](const KeyEvent& e) { handleKey(e, window); });
+            } else {
+                auto apply = [this](const KeyEvent& e) {
+                    handleKey(e, window);
+                    if (recorder && recorder->is_open()) recorder->record(e);
+                };
+                for (KeyEvent e; keyEvents.pop(e);) {
+                    e.tick = tick;
+                    apply(e);
+                }
+                receiveJob(tick, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), apply);
+            }
+            processInput();
+            rotation_manager.step();
+            takeSnapshot(snapshots.back());
+            snapshots.publish();
+
+            if (period.count() > 0) {
+                next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+                std::this_thread::sleep_until(next);
+            }
         }
-    } else if (key6_pressed) {
-        key6_pressed = false;
+        finished = true;
     }
+};
 
+#ifndef __EMSCRIPTEN__
+// Where the video of `--capture -` goes (see `takeStandardOutput`)
+std::FILE* videoOutput = stdout;
 
+/**
+ * Keeps the standard output for the video: the video is written to a copy of it, and all
+ * the rest printed to the standard output (here, or by the shaders and the solvers) goes to
+ * the standard error instead.
+ */
+void takeStandardOutput()
+{
+    std::cout.flush();
+    std::fflush(stdout);
+    int video = dup(STDOUT_FILENO);
+    if (video < 0) return;
+    std::FILE* file = fdopen(video, "wb");
+    if (!file || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        if (file) std::fclose(file);
+        else close(video);
+        return;
+    }
+    videoOutput = file;
 }
 
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-void framebuffer_size_callback(GLFWwindow *window, int width, int height)
+/**
+ * Writer of the captured frames: a video on the standard output if `path` is "-", else a
+ * sequence of images `<path>00000.png`, `<path>00001.png`...
+ */
+FrameCapture::Writer captureWriter(const std::string& path, int width, int height)
 {
-    // make sure the viewport matches the new window dimensions; note that width and
-    // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    if (path == "-") return Y4mWriter(videoOutput, width, height);
+    return PngSequenceWriter(path, width, height);
 }
 
 /**
- * A function that loads a texture from a given path
+ * Renders `frames` frames without a window, into memory: the same frames as in the window,
+ * with the inputs of the recording (if any) and the moves queued. The frames are written to
+ * `capture_path` if there is one (see `captureWriter`).
+ *
+ * The messages go to the standard error, which leaves the standard output to the video.
  */
-void load_gl_texture(unsigned int& id, const char* path, bool rgba = false) {
-    glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load image, create texture and generate mipmaps
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
-    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        if (rgba)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        else
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+int renderOffscreen(int frames, InputReplay* replay, const std::string& capture_path)
+{
+    OffscreenContext context;
+    if (!context.create(SCR_WIDTH, SCR_HEIGHT)) {
+        std::cerr << "Failed to create an offscreen OpenGL context" << endl;
+        return 1;
     }
-    else
+
+    // Without a file, a checksum of the last frame, to compare the images of two runs
+    uint64_t checksum = 0;
+    FrameCapture::Writer write = [&checksum](const uint8_t* rgba, uint64_t) {
+        checksum = 14695981039346656037ull;
+        for (size_t i = 0; i < size_t(SCR_WIDTH) * SCR_HEIGHT * 4; i++) checksum = (checksum ^ rgba[i]) * 1099511628211ull;
+        return true;
+    };
+    if (!capture_path.empty()) write = captureWriter(capture_path, SCR_WIDTH, SCR_HEIGHT);
+
+    double seconds = 0;
+    bool written = false;
     {
-        std::cout << "Failed to load texture" << std::endl;
+        Scene scene;
+        Snapshot snapshot;
+        FrameCapture capture(SCR_WIDTH, SCR_HEIGHT, write);
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            if (replay) replay->play(frame, [](const KeyEvent& e) { handleKey(e, NULL); });
+            processInput();
+            rotation_manager.step();
+            takeSnapshot(snapshot);
+            scene.render(snapshot, (float)SCR_WIDTH / (float)SCR_HEIGHT);
+            capture.capture();
+        }
+        written = capture.finish();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     }
-    stbi_image_free(data);
+
+    std::cerr << frames << " frames of " << SCR_WIDTH << "x" << SCR_HEIGHT << " in " << seconds << " s ("
+              << frames / seconds << " frames / s)";
+    if (capture_path.empty()) std::cerr << ", last frame " << std::hex << checksum << std::dec;
+    std::cerr << endl;
+    if (!written) std::cerr << "Failed to write the frames to " << capture_path << endl;
+    return written ? 0 : 1;
 }
 
-// settings
-const unsigned int SCR_WIDTH = 800;
-const unsigned int SCR_HEIGHT = 600;
+/**
+ * Renders a thumbnail of the cube reached by each line of moves of `input` (the 3x3x3
+ * notation, on a new cube of `size`), as sheets of `columns` x `columns` tiles of `tile`
+ * pixels: `<prefix>00000.png`, `<prefix>00001.png`... The thumbnails are in the order of
+ * the lines, row by row, and a whole sheet is one draw call and one readback.
+ */
+int renderThumbnails(int size, const std::string& input, const std::string& prefix, int tile, int columns)
+{
+    std::ifstream file(input);
+    if (!file) {
+        std::cerr << "Cannot read " << input << endl;
+        return 1;
+    }
+    std::vector<std::vector<Move>> algorithms;
+    for (std::string line; std::getline(file, line);)
+        algorithms.push_back(parse_moves(line));
+
+    OffscreenContext context;
+    if (!context.create(tile * columns, tile * columns)) {
+        std::cerr << "Failed to create an offscreen OpenGL context" << endl;
+        return 1;
+    }
+    // From the corner of the U, F and R faces
+    glm::vec3 camera_pos = glm::normalize(glm::vec3(1.0f, 1.1f, 1.4f)) * (1.5f * size);
+    glm::vec3 camera_up(0.0f, 1.0f, 0.0f);
 
-using std::cout;
-using std::endl;
+    auto start = std::chrono::steady_clock::now();
+    size_t per_sheet = size_t(columns) * columns, sheets = 0;
+    bool written = false;
+    {
+        Scene scene;
+        FrameCapture capture(context.get_width(), context.get_height(),
+                             PngSequenceWriter(prefix, context.get_width(), context.get_height()));
+        std::vector<RubicsCube> cubes;
+        for (size_t first = 0; first < algorithms.size(); first += per_sheet, sheets++) {
+            cubes.clear();
+            for (size_t i = first; i < std::min(algorithms.size(), first + per_sheet); i++) {
+                cubes.emplace_back(size);
+                RotationManager turns(&cubes.back());
+                turns.queue_moves(algorithms[i]);
+                turns.finish();
+            }
+            scene.render_tiles(cubes, columns, columns, camera_pos, camera_up, 1.0f);
+            capture.capture();
+        }
+        written = capture.finish();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << algorithms.size() << " thumbnails on " << sheets << " sheets in " << seconds << " s ("
+              << algorithms.size() / seconds << " thumbnails / s)" << endl;
+    if (!written) std::cerr << "Failed to write the sheets to " << prefix << endl;
+    return written ? 0 : 1;
+}
+#endif
 
-int main()
+int main(int argc, char** argv)
 {
+    // Usage: Hello3D [size] [--record <file> | --replay <file> [--headless]]
+    //                [--moves "<moves>"] [--offscreen <frames>] [--capture <prefix> | --capture -]
+    //        Hello3D [size] --thumbnails <moves file> <prefix> [--tile <pixels>] [--columns <tiles>]
+    int size = 0;
+    std::string record_path, replay_path, moves, capture_path, thumbnails_input, thumbnails_prefix;
+    bool headless = false;
+    int offscreen_frames = 0, tile = 128, columns = 16;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) record_path = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) replay_path = argv[++i];
+        else if (arg == "--headless") headless = true;
+        else if (arg == "--moves" && i + 1 < argc) moves = argv[++i];
+        else if (arg == "--capture" && i + 1 < argc) capture_path = argv[++i];
+        else if (arg == "--thumbnails" && i + 2 < argc) {
+            thumbnails_input = argv[++i];
+            thumbnails_prefix = argv[++i];
+        }
+        else if (arg == "--tile" && i + 1 < argc) tile = std::max(16, std::atoi(argv[++i]));
+        else if (arg == "--columns" && i + 1 < argc) columns = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--offscreen" && i + 1 < argc) offscreen_frames = std::max(1, std::atoi(argv[++i]));
+        else size = std::max(2, std::min(64, std::atoi(argv[i])));
+    }
+
+#ifndef __EMSCRIPTEN__
+    if (capture_path == "-") takeStandardOutput();
+    if (!thumbnails_input.empty())
+        return renderThumbnails(size ? size : 3, thumbnails_input, thumbnails_prefix, tile, columns);
+#endif
+
+    // A recording starts from a new cube, with the scrambles of its seed
+    InputRecorder recorder;
+    InputReplay replay;
+    uint64_t seed = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (!replay_path.empty()) {
+        if (!replay.load(replay_path)) {
+            std::cerr << "Cannot read the recording " << replay_path << endl;
+            return 1;
+        }
+        size = replay.size();
+        seed = replay.seed();
+        replaying = true;
+    } else if (!record_path.empty() && !recorder.open(record_path, size ? size : 3, seed)) {
+        std::cerr << "Cannot write the recording " << record_path << endl;
+        return 1;
+    }
+    scrambler = Scrambler(seed);
+    bool new_cube = size || !record_path.empty();
+
+    // The size of the rubicscube is given on the command line. Without it, the last session
+    // goes on (or a new 3x3x3 starts).
+    if (new_cube || !Session::load(Session::DEFAULT_PATH, game, cameraPos, cameraUp)) {
+        game = RubicsCube(size ? size : 3);
+        game.set_main_color(Color::BLUE);
+        cameraPos = glm::vec3(0.0f, 0.0f, 5.0f * game.size / 3.0f);
+    }
+    // Moves to play from the start, in the 3x3x3 notation (on the outer layers)
+    if (!moves.empty()) rotation_manager.queue_moves(parse_moves(moves));
+#ifndef __EMSCRIPTEN__
+    if (offscreen_frames)
+        return renderOffscreen(offscreen_frames, replay_path.empty() ? NULL : &replay, capture_path);
+#endif
+    if (headless) {
+        if (replay_path.empty()) {
+            cout << "--headless needs a recording to replay" << endl;
+            return 1;
+        }
+        return replayHeadless(replay);
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -236,196 +1118,99 @@ int main()
 
     // glfw window creation
     // --------------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    const std::string title = "LearnOpenGL";
+    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, title.c_str(), NULL, NULL);
     if (window == NULL)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
         return -1;
     }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    // The keys (and the mouse) of a replay come from the recording
+    if (replay_path.empty()) {
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetMouseButtonCallback(window, mouse_button_callback);
+    }
+    // A replay runs as fast as possible
+    if (!replay_path.empty()) glfwSwapInterval(0);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        std::cerr << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
 
-    // build and compile our shader zprogram
-    // ------------------------------------
-    // Shader ourShader("6.1.coordinate_systems.vs", "6.1.coordinate_systems.fs");
-    Shader ourShader("/home/arthur/dev/cpp/tuto1/shader_vert.glsl", "/home/arthur/dev/cpp/tuto1/shader_frag.glsl");
-
-    // set up vertex data (and buffer(s)) and configure vertex attributes
-    // ------------------------------------------------------------------
-
-    /*
-     * Faces are each assigned to a number as defined below
+    Scene scene;
 
-            Back   = 0
-            Front  = 1
-            Left   = 2
-            Right  = 3
-            Bottom = 4
-            Top    = 5 
-
-     */
-    float vertices[] = {
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 0.0f,
-        0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f,
-        0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
-        0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
-        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 0.0f,
-
-        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f,
-        0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 1.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 1.0f, 1.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 1.0f, 1.0f,
-        -0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 1.0f,
-        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f,
-
-        -0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 2.0f,
-        -0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 2.0f,
-        -0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 2.0f,
-        -0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 2.0f,
-        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 2.0f,
-        -0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 2.0f,
-
-        0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 3.0f,
-        0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 3.0f,
-        0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 3.0f,
-        0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 3.0f,
-        0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 3.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 3.0f,
-
-        -0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 4.0f,
-        0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 4.0f,
-        0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 4.0f,
-        0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 4.0f,
-        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 4.0f,
-        -0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 4.0f,
-
-        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 5.0f,
-        0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 5.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 5.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 5.0f,
-        -0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 5.0f,
-        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 5.0f
-        };
-
-    // Setup VBO, VAO and EBO
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-
-    // texture coord attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // load and create a texture
-    // -------------------------
-    load_gl_texture(yellow, "/home/arthur/dev/cpp/tuto1/resources/yellow.png");
-    load_gl_texture(red, "/home/arthur/dev/cpp/tuto1/resources/red.png");
-    load_gl_texture(white, "/home/arthur/dev/cpp/tuto1/resources/white.png");
-    load_gl_texture(blue, "/home/arthur/dev/cpp/tuto1/resources/blue.png");
-    load_gl_texture(orange, "/home/arthur/dev/cpp/tuto1/resources/orange.png");
-    load_gl_texture(green, "/home/arthur/dev/cpp/tuto1/resources/green.png");
-    load_gl_texture(none, "/home/arthur/dev/cpp/tuto1/resources/selected.png", true);
-
-    ourShader.use();
-
-    ourShader.setInt("texture0", 0);
-    ourShader.setInt("texture1", 1);
-    ourShader.setInt("texture2", 2);
-    ourShader.setInt("texture3", 3);
-    ourShader.setInt("texture4", 4);
-    ourShader.setInt("texture5", 5);
-    ourShader.setInt("textureNone", 6);
-
-    // Activate depth buffer
-    glEnable(GL_DEPTH_TEST);
-
-    game.set_main_color(Color::BLUE);
+    // Export of the frames, at the size of the framebuffer
+    std::unique_ptr<FrameCapture> capture;
+    if (!capture_path.empty()) {
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        capture.reset(new FrameCapture(width, height, captureWriter(capture_path, width, height)));
+    }
 
     // Wireframe mode ?
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    // render loop
-    Color colors[3] = {Color::NONE, Color::NONE, Color::NONE};
-    while (!glfwWindowShouldClose(window))
+    // The game runs on its own thread (as fast as possible for a replay), the window only
+    // sends it the keys and draws its snapshots
+    Simulation simulation(window, &recorder, replay_path.empty() ? NULL : &replay,
+                          replay_path.empty() ? Simulation::TICK_RATE : 0);
+    simulation.start();
+
+    // render loop (the time of the key events starts with it)
+    glfwSetTime(0);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t frame = 0;
+    bool shows_solve = false;
+    double title_time = 0;
+    for (; !glfwWindowShouldClose(window) && !simulation.is_finished(); frame++)
     {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        processInput(window);
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // Makes every rotation 
-        rotation_manager.step();
-
-        // activate shader
-        ourShader.use();
-
-        // create transformations 
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = glm::mat4(1.0f);
-        glm::mat4 projection = glm::mat4(1.0f);
-
-        // Setup the camera
-        view = glm::lookAt(cameraPos, vec3(0., 0., 0.), cameraUp);
-        projection = glm::perspective(glm::radians(70.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-
-        ourShader.setMat4("model", model);
-        ourShader.setMat4("view", view);
-        ourShader.setMat4("projection", projection);
-
-        glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, none);
-
-        glBindVertexArray(VAO);
-        for (const auto& cube: game.cubes) {
-            // Get the colors of the cube
-            cube.fillColors(colors);
-
-            // FRONT 
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, color_to_code(colors[0]));
-            // RIGHT
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, color_to_code(colors[1]));
-            // TOP
-            glActiveTexture(GL_TEXTURE5);
-            glBindTexture(GL_TEXTURE_2D, color_to_code(colors[2]));
-            // also set the BOTTOM color to allow for swapping axis
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, color_to_code(colors[2]));
-
-            // Is this cube on the main face ? 
-            ourShader.setBool("onCurrentFace", game.is_cube_on_selected_face(cube));
-
-            // Set the model matrix to the transform of the cube and then render
-            ourShader.setMat4("model", cube.transform);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (simulation.snapshots.update()) {
+            // The progress of a solve, in the title (a few times per second)
+            const Snapshot& snapshot = simulation.snapshots.front();
+            if (snapshot.solving != shows_solve || (snapshot.solving && time > title_time + 0.25)) {
+                std::string text = title;
+                if (snapshot.solving)
+                    text += " - solving: depth " + std::to_string(snapshot.solve_depth) + ", "
+                          + std::to_string(snapshot.solve_nodes) + " nodes (ENTER to stop)";
+                glfwSetWindowTitle(window, text.c_str());
+                shows_solve = snapshot.solving;
+                title_time = time;
+            }
         }
+        scene.render(simulation.snapshots.front(), (float)SCR_WIDTH / (float)SCR_HEIGHT);
+        if (capture) capture->capture();
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         glfwSwapBuffers(window);
         glfwPollEvents();
+        flushKeyEvents();
+    }
+    simulation.stop();
+
+    if (capture && !capture->finish())
+        std::cerr << "Failed to write the frames to " << capture_path << std::endl;
+    capture.reset();
+    if (recorder.is_open() && !recorder.close())
+        std::cerr << "Failed to write the recording " << record_path << std::endl;
+
+    // Save the cube as it is at the end of the moves in progress (a replay leaves the session as it was)
+    rotation_manager.finish();
+    if (!replay_path.empty()) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << simulation.ticks() << " ticks in " << seconds << " s (" << simulation.ticks() / seconds
+                  << " ticks / s), " << frame << " frames drawn" << std::endl;
+    } else if (!Session::save(Session::DEFAULT_PATH, game, cameraPos, cameraUp)) {
+        std::cerr << "Failed to save the session" << std::endl;
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
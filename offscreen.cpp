@@ -0,0 +1,117 @@
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+#include <cstdint>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+/**
+ * An OpenGL 3.3 context without a window or a display, rendering into a framebuffer in
+ * memory. It uses EGL without a surface (Mesa's surfaceless platform, or the default display
+ * of the driver), so it also works on a server without X, with llvmpipe.
+ *
+ * Once created, the context is current and the framebuffer is bound: the same draw calls as
+ * in a window render into it, and `read_pixels` gives back the image.
+ */
+class OffscreenContext {
+public:
+    OffscreenContext() = default;
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+    ~OffscreenContext() { destroy(); }
+
+    /// @return Returns false if there is no EGL display or no OpenGL 3.3 core context
+    bool create(int _width, int _height) {
+        destroy();
+        width = _width;
+        height = _height;
+
+        auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display)
+            display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+            display = EGL_NO_DISPLAY;
+            return false;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) return false;
+
+        // The framebuffer is ours, the config only matters to drivers that need one
+        const EGLint config_attributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLConfig config = EGL_NO_CONFIG_KHR;
+        EGLint configs = 0;
+        if (!eglChooseConfig(display, config_attributes, &config, 1, &configs) || configs == 0)
+            config = EGL_NO_CONFIG_KHR;
+
+        const EGLint context_attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE,
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+            return false;
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+            return false;
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glGenRenderbuffers(2, renderbuffers);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            return false;
+        glViewport(0, 0, width, height);
+        return true;
+    }
+
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+
+    /// Size of an image of `read_pixels`
+    size_t frame_bytes() const { return size_t(width) * height * 4; }
+
+    /**
+     * Copies the last frame rendered, as RGBA rows from the bottom of the image to the top
+     * (OpenGL's order). Waits for the rendering to finish.
+     */
+    void read_pixels(uint8_t* rgba) const {
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    }
+
+private:
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    unsigned int framebuffer = 0;
+    unsigned int renderbuffers[2] = {0, 0};
+    int width = 0;
+    int height = 0;
+
+    void destroy() {
+        if (context != EGL_NO_CONTEXT) {
+            if (framebuffer) {
+                glDeleteFramebuffers(1, &framebuffer);
+                glDeleteRenderbuffers(2, renderbuffers);
+            }
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(display, context);
+        }
+        if (display != EGL_NO_DISPLAY) eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+        context = EGL_NO_CONTEXT;
+        framebuffer = 0;
+        renderbuffers[0] = renderbuffers[1] = 0;
+    }
+};
+
+#endif
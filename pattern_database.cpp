@@ -0,0 +1,562 @@
+#ifndef PATTERN_DATABASE_H
+#define PATTERN_DATABASE_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cubestate.cpp"
+
+/**
+ * Pattern databases: for a subset of the pieces ("the pattern"), a table holding the exact
+ * number of moves needed to solve these pieces, for every way they can be placed.
+ *
+ * This is an admissible heuristic for IDA*, as solving the full cube requires at least
+ * as many moves as solving a part of it.
+ */
+
+/// @return Returns the rank of a permutation of {0..n-1} (Lehmer code), in [0, n!)
+inline uint32_t rank_permutation(const uint8_t* p, int n) {
+    uint32_t r = 0;
+    for (int i = 0; i < n; i++) {
+        int smaller = 0;
+        for (int j = i + 1; j < n; j++)
+            if (p[j] < p[i]) smaller++;
+        r = r * (n - i) + smaller;
+    }
+    return r;
+}
+
+/// Inverse of `rank_permutation`
+inline void unrank_permutation(uint32_t r, uint8_t* p, int n) {
+    for (int i = n - 1; i >= 0; i--) {
+        p[i] = r % (n - i);
+        r /= (n - i);
+        for (int j = i + 1; j < n; j++)
+            p[j] += p[j] >= p[i];
+    }
+}
+
+/**
+ * The 8 corners: 8! permutations times 3^7 orientations (the last twist is implied).
+ */
+class CornerPattern {
+public:
+    static constexpr uint32_t PERMUTATIONS = 40320;
+    static constexpr uint32_t ORIENTATIONS = 2187;
+
+    CornerPattern() : perm_move(PERMUTATIONS * MOVE_COUNT), ori_move(ORIENTATIONS * MOVE_COUNT) {
+        // Move tables: one entry per coordinate and per move
+        CubeState s;
+        for (uint32_t p = 0; p < PERMUTATIONS; p++) {
+            unrank_permutation(p, s.cp.data(), 8);
+            for (int m = 0; m < MOVE_COUNT; m++) {
+                CubeState t = s * CubeState::moves()[m];
+                perm_move[p * MOVE_COUNT + m] = rank_permutation(t.cp.data(), 8);
+            }
+        }
+        s = CubeState();
+        for (uint32_t o = 0; o < ORIENTATIONS; o++) {
+            set_orientation(s, o);
+            for (int m = 0; m < MOVE_COUNT; m++) {
+                CubeState t = s * CubeState::moves()[m];
+                ori_move[o * MOVE_COUNT + m] = orientation(t);
+            }
+        }
+    }
+
+    uint64_t size() const { return uint64_t(PERMUTATIONS) * ORIENTATIONS; }
+    /// Number of indices that can be reached from solved
+    uint64_t states() const { return size(); }
+
+    uint64_t index(const CubeState& s) const {
+        return uint64_t(rank_permutation(s.cp.data(), 8)) * ORIENTATIONS + orientation(s);
+    }
+
+    /**
+     * Fills `out` with the index reached by each of the 18 moves.
+     * @return Returns the number of successors
+     */
+    int successors(uint64_t index, uint64_t* out) const {
+        uint32_t p = index / ORIENTATIONS, o = index % ORIENTATIONS;
+        for (int m = 0; m < MOVE_COUNT; m++)
+            out[m] = uint64_t(perm_move[p * MOVE_COUNT + m]) * ORIENTATIONS + ori_move[o * MOVE_COUNT + m];
+        return MOVE_COUNT;
+    }
+
+private:
+    std::vector<uint16_t> perm_move;
+    std::vector<uint16_t> ori_move;
+
+    static uint32_t orientation(const CubeState& s) {
+        uint32_t o = 0;
+        for (int i = 0; i < 7; i++) o = o * 3 + s.co[i];
+        return o;
+    }
+
+    static void set_orientation(CubeState& s, uint32_t o) {
+        int sum = 0;
+        for (int i = 6; i >= 0; i--) {
+            s.co[i] = o % 3;
+            sum += s.co[i];
+            o /= 3;
+        }
+        s.co[7] = (3 - sum % 3) % 3;
+    }
+};
+
+/**
+ * 6 of the 12 edges: the positions they occupy (12 * 11 * ... * 7) times their flips (2^6).
+ *
+ * Two instances (edges 0..5 and edges 6..11) give two independent tables.
+ */
+class EdgePattern {
+public:
+    static constexpr int PIECES = 6;
+    static constexpr uint32_t PLACEMENTS = 665280;
+
+    /// @param _first Index of the first edge of the pattern (0 or 6)
+    EdgePattern(int _first) : first(_first) {
+        for (int m = 0; m < MOVE_COUNT; m++) {
+            const CubeState& t = CubeState::moves()[m];
+            for (int q = 0; q < CubeState::EDGES; q++) {
+                destination[m][t.ep[q]] = q;
+                flip[m][t.ep[q]] = t.eo[q];
+            }
+        }
+    }
+
+    uint64_t size() const { return uint64_t(PLACEMENTS) << PIECES; }
+    uint64_t states() const { return size(); }
+
+    uint64_t index(const CubeState& s) const {
+        uint8_t pos[PIECES], ori[PIECES];
+        for (int i = 0; i < CubeState::EDGES; i++) {
+            int e = s.ep[i] - first;
+            if (e >= 0 && e < PIECES) { pos[e] = i; ori[e] = s.eo[i]; }
+        }
+        return encode(pos, ori);
+    }
+
+    int successors(uint64_t index, uint64_t* out) const {
+        uint8_t pos[PIECES], ori[PIECES], npos[PIECES], nori[PIECES];
+        decode(index, pos, ori);
+        for (int m = 0; m < MOVE_COUNT; m++) {
+            for (int e = 0; e < PIECES; e++) {
+                npos[e] = destination[m][pos[e]];
+                nori[e] = ori[e] ^ flip[m][pos[e]];
+            }
+            out[m] = encode(npos, nori);
+        }
+        return MOVE_COUNT;
+    }
+
+private:
+    int first;
+    /// destination[m][p]: where the edge at position p goes with move m
+    uint8_t destination[MOVE_COUNT][CubeState::EDGES];
+    /// flip[m][p]: whether the edge at position p is flipped by move m
+    uint8_t flip[MOVE_COUNT][CubeState::EDGES];
+
+    static uint64_t encode(const uint8_t* pos, const uint8_t* ori) {
+        uint64_t r = 0;
+        uint32_t o = 0;
+        for (int i = 0; i < PIECES; i++) {
+            int smaller = 0;
+            for (int j = 0; j < i; j++)
+                if (pos[j] < pos[i]) smaller++;
+            r = r * (CubeState::EDGES - i) + pos[i] - smaller;
+            o = o * 2 + ori[i];
+        }
+        return (r << PIECES) | o;
+    }
+
+    static void decode(uint64_t index, uint8_t* pos, uint8_t* ori) {
+        uint32_t o = index & ((1 << PIECES) - 1);
+        uint64_t r = index >> PIECES;
+        for (int i = PIECES - 1; i >= 0; i--) {
+            ori[i] = o & 1;
+            o >>= 1;
+            pos[i] = r % (CubeState::EDGES - i);
+            r /= (CubeState::EDGES - i);
+        }
+        // pos[i] is the rank of the position among the ones left free by the previous edges
+        bool used[CubeState::EDGES] = {};
+        for (int i = 0; i < PIECES; i++) {
+            int k = pos[i];
+            int p = 0;
+            while (used[p] || k > 0) {
+                if (!used[p]) k--;
+                p++;
+            }
+            used[p] = true;
+            pos[i] = p;
+        }
+    }
+};
+
+/**
+ * A subgroup of the cube: some of the pieces, moved by some of the moves only.
+ *
+ * The moves must keep the pieces within the given positions (e.g. <U,R> only moves the
+ * pieces of the U and R faces). The index is made of the permutation of the corners, their
+ * orientation (the last twist is implied), the permutation of the edges and, if the moves
+ * flip edges, their orientation.
+ */
+class SubgroupPattern {
+public:
+    /**
+     * @param _corners Positions of the corners of the subgroup
+     * @param _edges Positions of the edges of the subgroup
+     * @param _moves Moves generating the subgroup
+     * @param _states Number of states of the subgroup, if some indices cannot be reached
+     */
+    SubgroupPattern(std::vector<int> _corners, std::vector<int> _edges, std::vector<Move> _moves, uint64_t _states = 0)
+        : corners(_corners), edges(_edges), moves(_moves) {
+        corner_perms = factorial(corners.size());
+        corner_oris = power(3, corners.empty() ? 0 : corners.size() - 1);
+        edge_perms = factorial(edges.size());
+        flips = false;
+        for (Move m: moves)
+            for (int e: edges)
+                if (CubeState::moves()[m].eo[e]) flips = true;
+        edge_oris = flips ? power(2, edges.size() - 1) : 1;
+        reachable = _states ? _states : size();
+
+        // Move tables, one row of `moves.size()` entries per coordinate
+        const size_t n = moves.size();
+        corner_perm_move.resize(corner_perms * n);
+        corner_ori_move.resize(corner_oris * n);
+        edge_perm_move.resize(edge_perms * n);
+        edge_ori_move.resize(edge_oris * n);
+        for (uint32_t c = 0; c < corner_perms; c++)
+            for (size_t m = 0; m < n; m++)
+                corner_perm_move[c * n + m] = corner_permutation(state(c, 0, 0, 0) * CubeState::moves()[moves[m]]);
+        for (uint32_t c = 0; c < corner_oris; c++)
+            for (size_t m = 0; m < n; m++)
+                corner_ori_move[c * n + m] = corner_orientation(state(0, c, 0, 0) * CubeState::moves()[moves[m]]);
+        for (uint32_t e = 0; e < edge_perms; e++)
+            for (size_t m = 0; m < n; m++)
+                edge_perm_move[e * n + m] = edge_permutation(state(0, 0, e, 0) * CubeState::moves()[moves[m]]);
+        for (uint32_t e = 0; e < edge_oris; e++)
+            for (size_t m = 0; m < n; m++)
+                edge_ori_move[e * n + m] = edge_orientation(state(0, 0, 0, e) * CubeState::moves()[moves[m]]);
+    }
+
+    /// The 2x2x2 cube: the corners, turned with U, R and F only (the DBL corner never moves)
+    static SubgroupPattern pocket_cube() {
+        return SubgroupPattern({0, 1, 2, 3, 4, 5, 7}, {}, {U1, U2, U3, R1, R2, R3, F1, F2, F3});
+    }
+
+    /// The <U,R> group: the pieces of the U and R faces, turned with U and R only
+    static SubgroupPattern two_generator() {
+        return SubgroupPattern({0, 1, 2, 3, 4, 7}, {0, 1, 2, 3, 4, 8, 11}, {U1, U2, U3, R1, R2, R3}, 73483200);
+    }
+
+    uint64_t size() const { return uint64_t(edge_perms) * edge_oris * corner_perms * corner_oris; }
+    uint64_t states() const { return reachable; }
+    const std::vector<Move>& generators() const { return moves; }
+
+    uint64_t index(const CubeState& s) const {
+        return compose(corner_permutation(s), corner_orientation(s), edge_permutation(s), edge_orientation(s));
+    }
+
+    int successors(uint64_t index, uint64_t* out) const {
+        uint32_t co = index % corner_oris; index /= corner_oris;
+        uint32_t cp = index % corner_perms; index /= corner_perms;
+        uint32_t eo = index % edge_oris; index /= edge_oris;
+        uint32_t ep = index;
+        const size_t n = moves.size();
+        for (size_t m = 0; m < n; m++)
+            out[m] = compose(corner_perm_move[cp * n + m], corner_ori_move[co * n + m],
+                             edge_perm_move[ep * n + m], edge_ori_move[eo * n + m]);
+        return int(n);
+    }
+
+    /// @return Returns the state of a given index (the pieces out of the subgroup are solved)
+    CubeState state(uint64_t index) const {
+        uint32_t co = index % corner_oris; index /= corner_oris;
+        uint32_t cp = index % corner_perms; index /= corner_perms;
+        uint32_t eo = index % edge_oris; index /= edge_oris;
+        return state(cp, co, index, eo);
+    }
+
+private:
+    std::vector<int> corners, edges;
+    std::vector<Move> moves;
+    uint32_t corner_perms, corner_oris, edge_perms, edge_oris;
+    bool flips;
+    uint64_t reachable;
+    std::vector<uint32_t> corner_perm_move, corner_ori_move, edge_perm_move, edge_ori_move;
+
+    static uint32_t factorial(int n) { return n <= 1 ? 1 : n * factorial(n - 1); }
+    static uint32_t power(uint32_t b, int n) { return n <= 0 ? 1 : b * power(b, n - 1); }
+
+    uint64_t compose(uint32_t cp, uint32_t co, uint32_t ep, uint32_t eo) const {
+        return ((uint64_t(ep) * edge_oris + eo) * corner_perms + cp) * corner_oris + co;
+    }
+
+    /// @return Returns the local index (in `list`) of a piece
+    static uint8_t local(const std::vector<int>& list, int piece) {
+        for (size_t i = 0; i < list.size(); i++)
+            if (list[i] == piece) return i;
+        return 0;
+    }
+
+    uint32_t corner_permutation(const CubeState& s) const {
+        uint8_t p[CubeState::CORNERS];
+        for (size_t i = 0; i < corners.size(); i++) p[i] = local(corners, s.cp[corners[i]]);
+        return rank_permutation(p, corners.size());
+    }
+
+    uint32_t corner_orientation(const CubeState& s) const {
+        uint32_t o = 0;
+        for (size_t i = 0; i + 1 < corners.size(); i++) o = o * 3 + s.co[corners[i]];
+        return o;
+    }
+
+    uint32_t edge_permutation(const CubeState& s) const {
+        uint8_t p[CubeState::EDGES];
+        for (size_t i = 0; i < edges.size(); i++) p[i] = local(edges, s.ep[edges[i]]);
+        return rank_permutation(p, edges.size());
+    }
+
+    uint32_t edge_orientation(const CubeState& s) const {
+        uint32_t o = 0;
+        if (flips)
+            for (size_t i = 0; i + 1 < edges.size(); i++) o = o * 2 + s.eo[edges[i]];
+        return o;
+    }
+
+    CubeState state(uint32_t cp, uint32_t co, uint32_t ep, uint32_t eo) const {
+        CubeState s;
+        uint8_t p[CubeState::EDGES];
+        unrank_permutation(cp, p, corners.size());
+        for (size_t i = 0; i < corners.size(); i++) s.cp[corners[i]] = corners[p[i]];
+        int sum = 0;
+        for (int i = int(corners.size()) - 2; i >= 0; i--) {
+            s.co[corners[i]] = co % 3;
+            sum += co % 3;
+            co /= 3;
+        }
+        if (!corners.empty()) s.co[corners.back()] = (3 - sum % 3) % 3;
+
+        unrank_permutation(ep, p, edges.size());
+        for (size_t i = 0; i < edges.size(); i++) s.ep[edges[i]] = edges[p[i]];
+        if (flips) {
+            sum = 0;
+            for (int i = int(edges.size()) - 2; i >= 0; i--) {
+                s.eo[edges[i]] = eo % 2;
+                sum += eo % 2;
+                eo /= 2;
+            }
+            s.eo[edges.back()] = sum % 2;
+        }
+        return s;
+    }
+};
+
+/**
+ * Header of a pattern database file. The depths follow, either packed two per byte (the low
+ * nibble holds the even index) or one per byte. An entry with all its bits set means "not
+ * reachable".
+ *
+ * The layout is meant to be mapped in memory as is, without any parsing.
+ */
+struct PatternDatabaseHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pattern;
+    uint64_t entries;
+    /// Bits per entry: 4 or 8, any other value is invalid
+    uint64_t entry_bits;
+};
+
+/**
+ * Identifiers of the patterns, stored in the header of the files.
+ */
+enum PatternId : uint32_t {
+    PATTERN_CORNERS = 1,
+    PATTERN_EDGES_FIRST = 2,
+    PATTERN_EDGES_LAST = 3,
+    PATTERN_POCKET = 4,
+};
+
+/// @return Returns the default file name of the table of a pattern
+inline std::string pattern_file_name(PatternId id) {
+    switch (id)
+    {
+    case PATTERN_CORNERS: return "corners.pdb";
+    case PATTERN_EDGES_FIRST: return "edges_first.pdb";
+    case PATTERN_EDGES_LAST: return "edges_last.pdb";
+    case PATTERN_POCKET: return "pocket.pdb";
+    }
+    return "unknown.pdb";
+}
+
+/**
+ * A table of depths, backed by a memory mapped file.
+ */
+class PatternDatabase {
+public:
+    PatternDatabase() = default;
+    PatternDatabase(const PatternDatabase&) = delete;
+    PatternDatabase& operator=(const PatternDatabase&) = delete;
+    ~PatternDatabase() { close(); }
+
+    /**
+     * Maps an existing table in memory (read only).
+     * @param entries Number of indices of the pattern
+     * @return Returns false if the file is missing or is not a table of the given pattern
+     */
+    bool load(const std::string& path, PatternId pattern, uint64_t entries) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(PatternDatabaseHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        mapping = static_cast<uint8_t*>(p);
+        mapping_size = st.st_size;
+
+        const PatternDatabaseHeader* h = header();
+        packed = h->entry_bits == 4;
+        if (std::memcmp(h->magic, MAGIC, sizeof(h->magic)) != 0 || h->version != VERSION
+            || h->pattern != pattern || h->entries != entries || (h->entry_bits != 4 && h->entry_bits != 8)
+            || mapping_size < sizeof(PatternDatabaseHeader) + bytes(h->entries)) {
+            std::cout << "Invalid pattern database: " << path << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Creates a table of the given size, and maps it in memory (read / write). All the
+     * entries start as `unreached()`.
+     *
+     * The table is written to a temporary file, which only takes the name `path` once it is
+     * complete (see `finish`): a search that is interrupted leaves no table that would load.
+     *
+     * @param entry_bits 4 (two entries per byte, for depths up to 14) or 8 (one per byte)
+     * @return Returns false if the file cannot be created, or for another `entry_bits`
+     */
+    bool create(const std::string& path, PatternId pattern, uint64_t entries, int entry_bits = 4) {
+        close();
+        if (entry_bits != 4 && entry_bits != 8) return false;
+        std::string temporary = path + ".tmp";
+        int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        packed = entry_bits != 8;
+        size_t total = sizeof(PatternDatabaseHeader) + bytes(entries);
+        if (ftruncate(fd, total) != 0) {
+            ::close(fd);
+            ::unlink(temporary.c_str());
+            return false;
+        }
+        void* p = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            ::unlink(temporary.c_str());
+            return false;
+        }
+        mapping = static_cast<uint8_t*>(p);
+        mapping_size = total;
+        pending_path = path;
+
+        PatternDatabaseHeader* h = reinterpret_cast<PatternDatabaseHeader*>(mapping);
+        std::memcpy(h->magic, MAGIC, sizeof(h->magic));
+        h->version = VERSION;
+        h->pattern = pattern;
+        h->entries = entries;
+        h->entry_bits = packed ? 4 : 8;
+        std::memset(data(), 0xFF, bytes(entries));
+        return true;
+    }
+
+    /**
+     * Writes a table made by `create` to the disk and gives it its name.
+     * @return Returns false if it cannot be written, in which case there is no table
+     */
+    bool finish() {
+        if (!mapping || pending_path.empty()) return false;
+        std::string path = pending_path, temporary = path + ".tmp";
+        bool ok = msync(mapping, mapping_size, MS_SYNC) == 0;
+        pending_path.clear();
+        close();
+        if (ok) ok = std::rename(temporary.c_str(), path.c_str()) == 0;
+        if (!ok) ::unlink(temporary.c_str());
+        return ok;
+    }
+
+    /// Unmaps the table (a table created and not finished is deleted)
+    void close() {
+        if (mapping) munmap(mapping, mapping_size);
+        if (!pending_path.empty()) ::unlink((pending_path + ".tmp").c_str());
+        mapping = nullptr;
+        mapping_size = 0;
+        pending_path.clear();
+    }
+
+    bool is_loaded() const { return mapping != nullptr; }
+
+    uint64_t entries() const { return header()->entries; }
+
+    bool is_packed() const { return packed; }
+
+    /// @return Returns the value of the entries not reached by the search
+    uint8_t unreached() const { return packed ? 0xF : 0xFF; }
+
+    /// @return Returns the depth stored for an index
+    uint8_t operator[](uint64_t index) const {
+        if (!packed) return data()[index];
+        uint8_t b = data()[index >> 1];
+        return (index & 1) ? b >> 4 : b & 0xF;
+    }
+
+    /// Stores the depth of an index (two threads must not write the same byte at once)
+    void set(uint64_t index, uint8_t depth) {
+        if (!packed) {
+            data()[index] = depth;
+            return;
+        }
+        uint8_t& b = data()[index >> 1];
+        b = (index & 1) ? (b & 0x0F) | (depth << 4) : (b & 0xF0) | depth;
+    }
+
+    /// @return Returns the depths (two entries per byte if packed)
+    uint8_t* data() { return mapping + sizeof(PatternDatabaseHeader); }
+    const uint8_t* data() const { return mapping + sizeof(PatternDatabaseHeader); }
+
+private:
+    static constexpr char MAGIC[8] = {'R', 'C', 'P', 'D', 'B', 0, 0, 0};
+    static constexpr uint32_t VERSION = 1;
+
+    uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+    bool packed = true;
+    /// The name of the table being created, until it is finished
+    std::string pending_path;
+
+    uint64_t bytes(uint64_t entries) const { return packed ? (entries + 1) / 2 : entries; }
+
+    const PatternDatabaseHeader* header() const {
+        return reinterpret_cast<const PatternDatabaseHeader*>(mapping);
+    }
+};
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef PATTERN_DATABASE_GENERATOR_H
+#define PATTERN_DATABASE_GENERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pattern_database.cpp"
+
+/**
+ * Runs `work(begin, end)` over [0, count) on several threads, by chunks.
+ */
+inline void parallel_for(uint64_t count, unsigned threads, const std::function<void(uint64_t, uint64_t)>& work) {
+    const uint64_t chunk = 1024;
+    std::atomic<uint64_t> next(0);
+    auto worker = [&]() {
+        for (;;) {
+            uint64_t begin = next.fetch_add(chunk);
+            if (begin >= count) return;
+            work(begin, std::min(count, begin + chunk));
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& t: pool) t.join();
+}
+
+/**
+ * Breadth-first search over all the indices of a pattern, on all cores.
+ *
+ * The search keeps three bitmaps (one bit per index): the states already visited, the
+ * current frontier and the next frontier. Threads claim states with an atomic OR on the
+ * visited bitmap, so that each state is expanded exactly once without any lock.
+ *
+ * Once more than half of the states are visited, the search goes backward: instead of
+ * expanding the frontier, each unvisited state checks if one of its neighbors is in the
+ * frontier. This is much cheaper at the end, when almost every successor is already known.
+ * Only the patterns whose indices are all states do so (`size() == states()`): for the others
+ * the unvisited indices are mostly unreachable ones, checked again at every level.
+ *
+ * `Pattern` must provide `size()`, `states()`, `index(CubeState)` and `successors(index, out)`.
+ * The moves are their own inverses as a set, so successors are also predecessors.
+ */
+template <class Pattern>
+class PatternDatabaseGenerator {
+public:
+    PatternDatabaseGenerator(const Pattern& _pattern, unsigned _threads = std::thread::hardware_concurrency())
+        : pattern(_pattern), threads(_threads ? _threads : 1) { }
+
+    /// Print the progress of each level on the standard output
+    bool verbose = false;
+
+    /**
+     * Runs the search from the given start states.
+     *
+     * @param on_level Called after each level with the depth and the bitmap of its states,
+     *                 in words of 64 indices, so that callers can store the depths.
+     * @return Returns the number of states found at each depth
+     */
+    std::vector<uint64_t> run(const std::vector<CubeState>& starts,
+                              const std::function<void(int, const std::atomic<uint64_t>*, uint64_t)>& on_level) {
+        const uint64_t size = pattern.size();
+        const uint64_t words = (size + 63) / 64;
+        std::unique_ptr<std::atomic<uint64_t>[]> visited(new std::atomic<uint64_t>[words]);
+        std::unique_ptr<std::atomic<uint64_t>[]> current(new std::atomic<uint64_t>[words]);
+        std::unique_ptr<std::atomic<uint64_t>[]> next(new std::atomic<uint64_t>[words]);
+        parallel_for(words, threads, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t w = begin; w < end; w++) {
+                visited[w].store(0, std::memory_order_relaxed);
+                current[w].store(0, std::memory_order_relaxed);
+                next[w].store(0, std::memory_order_relaxed);
+            }
+        });
+
+        std::vector<uint64_t> counts;
+        uint64_t found = 0;
+        for (const CubeState& s: starts) {
+            uint64_t i = pattern.index(s);
+            uint64_t bit = 1ull << (i & 63);
+            if (visited[i >> 6].fetch_or(bit) & bit) continue;
+            current[i >> 6].fetch_or(bit);
+            found++;
+        }
+        counts.push_back(found);
+        uint64_t total = found;
+        on_level(0, current.get(), words);
+        // The backward steps scan all the indices not visited, reachable or not
+        const bool dense = size == pattern.states();
+
+        for (int depth = 1; found > 0; depth++) {
+            auto start_time = std::chrono::steady_clock::now();
+            bool backward = dense && 2 * total > pattern.states();
+
+            if (backward) {
+                parallel_for(words, threads, [&](uint64_t begin, uint64_t end) {
+                    uint64_t out[MOVE_COUNT];
+                    for (uint64_t w = begin; w < end; w++) {
+                        uint64_t todo = ~visited[w].load(std::memory_order_relaxed);
+                        if (w == words - 1 && (size & 63)) todo &= (1ull << (size & 63)) - 1;
+                        uint64_t reached = 0;
+                        while (todo) {
+                            uint64_t i = w * 64 + __builtin_ctzll(todo);
+                            int n = pattern.successors(i, out);
+                            for (int k = 0; k < n; k++) {
+                                if (current[out[k] >> 6].load(std::memory_order_relaxed) & (1ull << (out[k] & 63))) {
+                                    reached |= 1ull << (i & 63);
+                                    break;
+                                }
+                            }
+                            todo &= todo - 1;
+                        }
+                        // Each thread owns its words: no need for an atomic read-modify-write
+                        next[w].store(reached, std::memory_order_relaxed);
+                    }
+                });
+            } else {
+                parallel_for(words, threads, [&](uint64_t begin, uint64_t end) {
+                    uint64_t out[MOVE_COUNT];
+                    for (uint64_t w = begin; w < end; w++) {
+                        uint64_t todo = current[w].load(std::memory_order_relaxed);
+                        while (todo) {
+                            uint64_t i = w * 64 + __builtin_ctzll(todo);
+                            int n = pattern.successors(i, out);
+                            for (int k = 0; k < n; k++) {
+                                std::atomic<uint64_t>& word = visited[out[k] >> 6];
+                                uint64_t bit = 1ull << (out[k] & 63);
+                                if (word.load(std::memory_order_relaxed) & bit) continue;
+                                if (!(word.fetch_or(bit, std::memory_order_relaxed) & bit))
+                                    next[out[k] >> 6].fetch_or(bit, std::memory_order_relaxed);
+                            }
+                            todo &= todo - 1;
+                        }
+                    }
+                });
+            }
+
+            // Swap the frontiers and count the new level
+            std::atomic<uint64_t> level_count(0);
+            parallel_for(words, threads, [&](uint64_t begin, uint64_t end) {
+                uint64_t c = 0;
+                for (uint64_t w = begin; w < end; w++) {
+                    uint64_t n = next[w].load(std::memory_order_relaxed);
+                    visited[w].fetch_or(n, std::memory_order_relaxed);
+                    current[w].store(n, std::memory_order_relaxed);
+                    next[w].store(0, std::memory_order_relaxed);
+                    c += __builtin_popcountll(n);
+                }
+                level_count += c;
+            });
+            found = level_count;
+            if (found == 0) break;
+            total += found;
+            counts.push_back(found);
+            on_level(depth, current.get(), words);
+
+            if (verbose) {
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+                std::cout << "depth " << depth << (backward ? " (backward)" : " (forward) ")
+                          << " : " << found << " states in " << seconds << " s" << std::endl;
+            }
+        }
+        return counts;
+    }
+
+    /**
+     * Runs the search from solved and writes the depths into a new table file. The file only
+     * takes its name once all the depths are in (see `PatternDatabase::finish`).
+     * @param entry_bits 4 (packed) or 8 (one byte per entry, see `PatternDatabase::create`)
+     * @return Returns the number of states at each depth, or nothing if the file could not be written
+     */
+    std::vector<uint64_t> generate(const std::string& path, PatternId id, int entry_bits = 4) {
+        PatternDatabase table;
+        if (!table.create(path, id, pattern.size(), entry_bits)) {
+            std::cout << "Cannot create " << path << std::endl;
+            return {};
+        }
+        const uint64_t size = pattern.size();
+        std::vector<uint64_t> counts = run({CubeState()}, [&](int depth, const std::atomic<uint64_t>* level, uint64_t words) {
+            // One word covers 32 bytes of the table (64 if not packed), so threads never
+            // write the same byte.
+            parallel_for(words, threads, [&](uint64_t begin, uint64_t end) {
+                for (uint64_t w = begin; w < end; w++) {
+                    uint64_t bits = level[w].load(std::memory_order_relaxed);
+                    while (bits) {
+                        uint64_t i = w * 64 + __builtin_ctzll(bits);
+                        if (i < size) table.set(i, depth);
+                        bits &= bits - 1;
+                    }
+                }
+            });
+        });
+        if (!table.finish()) {
+            std::cout << "Cannot write " << path << std::endl;
+            return {};
+        }
+        return counts;
+    }
+
+private:
+    const Pattern& pattern;
+    unsigned threads;
+};
+
+#endif
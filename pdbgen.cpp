@@ -0,0 +1,52 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "pattern_database_generator.cpp"
+
+using std::cout;
+using std::endl;
+
+/**
+ * Generates the pattern databases used by the solvers.
+ *
+ * Usage: PdbGen [corners|edges|pocket|all] [output directory] [threads]
+ */
+
+template <class Pattern>
+bool generate(const Pattern& pattern, PatternId id, const std::string& directory, unsigned threads, int entry_bits = 4) {
+    std::string path = directory + "/" + pattern_file_name(id);
+    cout << "Generating " << path << " (" << pattern.size() << " entries, " << threads << " threads)" << endl;
+
+    auto start = std::chrono::steady_clock::now();
+    PatternDatabaseGenerator<Pattern> generator(pattern, threads);
+    generator.verbose = true;
+    std::vector<uint64_t> counts = generator.generate(path, id, entry_bits);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (counts.empty()) return false;
+
+    uint64_t total = 0;
+    for (uint64_t c: counts) total += c;
+    cout << total << " states, max depth " << counts.size() - 1 << ", in " << seconds << " s" << endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string which = argc > 1 ? argv[1] : "all";
+    std::string directory = argc > 2 ? argv[2] : ".";
+    unsigned threads = argc > 3 ? std::stoi(argv[3]) : std::thread::hardware_concurrency();
+
+    bool ok = true;
+    if (which == "corners" || which == "all")
+        ok &= generate(CornerPattern(), PATTERN_CORNERS, directory, threads);
+    if (which == "edges" || which == "all") {
+        ok &= generate(EdgePattern(0), PATTERN_EDGES_FIRST, directory, threads);
+        ok &= generate(EdgePattern(6), PATTERN_EDGES_LAST, directory, threads);
+    }
+    // The exact distances of the 2x2x2, one byte per state
+    if (which == "pocket" || which == "all")
+        ok &= generate(SubgroupPattern::pocket_cube(), PATTERN_POCKET, directory, threads, 8);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#ifndef PICKING_H
+#define PICKING_H
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "rubicscube.cpp"
+
+/**
+ * Picking of the stickers with the mouse, on the CPU: a ray from the camera through the
+ * pointer is tested against the box of each cube. It needs nothing from the GPU (no reading
+ * back), and takes a few microseconds on a 3x3x3 (well under a millisecond on the biggest
+ * cubes).
+ */
+
+/// A half-line from `origin`, along `direction` (of length 1)
+struct Ray {
+    vec3 origin;
+    vec3 direction;
+};
+
+/**
+ * Returns the ray through a point of the screen, in OpenGL's coordinates: (-1, -1) at the
+ * bottom left, (1, 1) at the top right.
+ */
+inline Ray screen_ray(float x, float y, const mat4& view, const mat4& projection) {
+    mat4 unproject = glm::inverse(projection * view);
+    vec4 near_point = unproject * vec4(x, y, -1.0f, 1.0f);
+    vec4 far_point = unproject * vec4(x, y, 1.0f, 1.0f);
+    vec3 origin = vec3(near_point) / near_point.w;
+    return {origin, glm::normalize(vec3(far_point) / far_point.w - origin)};
+}
+
+/// A sticker hit by a ray
+struct Pick {
+    /// Index of the cube in `RubicsCube::cubes`, -1 if none
+    int cube = -1;
+    /// Face of the rubicscube the sticker is on, NONE for the inside of a layer being turned
+    Color face = Color::NONE;
+    /// Point hit, and its distance along the ray
+    vec3 point;
+    float distance = 0;
+};
+
+/**
+ * Finds the first cube hit by the ray, and the face of the rubicscube hit. Each cube is
+ * tested as a box of its own orientation, so the cubes of a turn in progress are found too.
+ * @return Returns false if the ray misses the rubicscube
+ */
+inline bool pick(const RubicsCube& game, const Ray& ray, Pick& result) {
+    result = Pick();
+    // The ray must pass close enough to the center, even for the corners of a turn in progress
+    float radius = (game.half_size() + 0.5f) * std::sqrt(3.0f);
+    float closest = glm::dot(-ray.origin, ray.direction);
+    if (glm::length(ray.origin + closest * ray.direction) > radius) return false;
+
+    vec3 normal;
+    for (size_t i = 0; i < game.cubes.size(); i++) {
+        const mat4& transform = game.cubes[i].transform;
+        // In the frame of the cube (its rotation is orthonormal), where it spans [-0.5, 0.5]^3
+        mat3 to_local = glm::transpose(mat3(transform));
+        vec3 origin = to_local * (ray.origin - vec3(transform[3]));
+        vec3 direction = to_local * ray.direction;
+
+        // Slabs: the ray is in the box between its entry into the last slab and its exit of the first one
+        float enter = -INFINITY, leave = INFINITY;
+        int axis = -1;
+        for (int a = 0; a < 3 && enter <= leave; a++) {
+            if (std::abs(direction[a]) < 1e-6f) {
+                if (std::abs(origin[a]) > 0.5f) leave = -INFINITY;
+                continue;
+            }
+            float t1 = (-0.5f - origin[a]) / direction[a];
+            float t2 = (0.5f - origin[a]) / direction[a];
+            if (std::min(t1, t2) > enter) {
+                enter = std::min(t1, t2);
+                axis = a;
+            }
+            leave = std::min(leave, std::max(t1, t2));
+        }
+        if (axis < 0 || enter > leave || enter < 0 || (result.cube >= 0 && enter >= result.distance)) continue;
+
+        result.cube = i;
+        result.distance = enter;
+        normal = vec3(0.0f);
+        normal[axis] = direction[axis] > 0 ? -1.0f : 1.0f;
+        normal = mat3(transform) * normal;
+    }
+    if (result.cube < 0) return false;
+
+    result.point = ray.origin + result.distance * ray.direction;
+    result.face = Color::of_axis(normal);
+    if (glm::dot(game.cubes[result.cube].position(), result.face.axis()) < game.half_size() - 0.25f)
+        result.face = Color::NONE;
+    return true;
+}
+
+/**
+ * Returns the turn of a drag from the sticker `from` to where the ray `to` meets the plane of
+ * its face: the layer of the sticker that moves along the drag (rounded to the closest axis
+ * of the face), a quarter turn in the direction of the drag.
+ * @return Returns false if the drag is shorter than `min_distance` (in cubes): a click
+ */
+inline bool drag_turn(const RubicsCube& game, const Pick& from, const Ray& to, LayerMove& move,
+                      float min_distance = 0.3f) {
+    if (from.cube < 0 || from.face == Color::NONE) return false;
+    vec3 n = from.face.axis();
+    float facing = glm::dot(to.direction, n);
+    if (std::abs(facing) < 1e-6f) return false;
+    float t = glm::dot(from.point - to.origin, n) / facing;
+    if (t < 0) return false;
+    vec3 drag = to.origin + t * to.direction - from.point;
+    drag -= glm::dot(drag, n) * n;
+    if (glm::length(drag) < min_distance) return false;
+
+    // The axis of the face closest to the drag
+    vec3 along(0.0f);
+    int a = std::abs(drag.x) >= std::abs(drag.y) && std::abs(drag.x) >= std::abs(drag.z) ? 0
+          : std::abs(drag.y) >= std::abs(drag.z) ? 1 : 2;
+    along[a] = drag[a] > 0 ? 1.0f : -1.0f;
+
+    // Turning counter-clockwise around n x along moves the face of n toward `along`
+    Color turned = Color::of_axis(glm::cross(n, along));
+    float depth = glm::dot(game.cubes[from.cube].position(), turned.axis());
+    int layer = int(std::round(game.half_size() - depth));
+    move = {turned.face(), uint8_t(layer), 3};
+    return true;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef POCKET_SOLVER_H
+#define POCKET_SOLVER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cubestate.cpp"
+#include "faceletcube.cpp"
+#include "pattern_database_generator.cpp"
+
+/**
+ * Optimal solver of the 2x2x2 cube, with the exact distance of every state in memory.
+ *
+ * A 2x2x2 is its 8 corners; turning it as a whole does not change it, so the DBL corner can
+ * be kept in place and the cube turned with U, R and F only: 7! x 3^6 = 3674160 states.
+ * The table holds one byte per state (3.5 MB). It is generated by the parallel breadth-first
+ * search the first time, and saved next to the other pattern databases. Any thread can load
+ * it: the first one maps (or generates) it, the others wait for it.
+ *
+ * A solve walks down the table: from a state at distance d, one of the 9 moves leads to a
+ * state at distance d - 1. This takes at most 11 x 9 lookups, a few microseconds.
+ */
+class PocketCubeSolver {
+public:
+    /// The largest distance of a 2x2x2 state
+    static constexpr int MAX_DEPTH = 11;
+
+    PocketCubeSolver(unsigned _threads = std::thread::hardware_concurrency())
+        : pattern(SubgroupPattern::pocket_cube()), threads(_threads ? _threads : 1) { }
+
+    /**
+     * Maps the table in memory, generating it first if the file is missing. Once it is
+     * loaded, it stays: the next calls return at once.
+     * @return Returns false if the table can neither be read nor written
+     */
+    bool load(const std::string& directory = ".") {
+        std::lock_guard<std::mutex> lock(loading);
+        if (loaded) return true;
+        std::string path = directory + "/" + pattern_file_name(PATTERN_POCKET);
+        if (!table.load(path, PATTERN_POCKET, pattern.size()) || table.is_packed()) {
+            PatternDatabaseGenerator<SubgroupPattern> generator(pattern, threads);
+            if (generator.generate(path, PATTERN_POCKET, 8).empty() || !table.load(path, PATTERN_POCKET, pattern.size()))
+                return false;
+        }
+        loaded = true;
+        return true;
+    }
+
+    bool is_loaded() const { return loaded; }
+
+    /// @return Returns the number of moves of an optimal solution (the edges are ignored)
+    int distance(const CubeState& s) const { return table[pattern.index(s)]; }
+
+    /**
+     * Finds an optimal solution of a state whose DBL corner is solved.
+     * @return Returns false if the DBL corner is not solved, or if the table does not lead
+     *         to solved from this state (a table that is not the one of the 2x2x2)
+     */
+    bool solve(const CubeState& s, std::vector<Move>& solution) const {
+        solution.clear();
+        if (s.cp[6] != 6 || s.co[6] != 0) return false;
+        uint64_t index = pattern.index(s);
+        if (table[index] > MAX_DEPTH) return false;
+        uint64_t next[MOVE_COUNT];
+        for (int d = table[index]; d > 0; d--) {
+            int n = pattern.successors(index, next);
+            int k = 0;
+            while (k < n && table[next[k]] != d - 1) k++;
+            if (k == n) {
+                solution.clear();
+                return false;
+            }
+            solution.push_back(pattern.generators()[k]);
+            index = next[k];
+        }
+        return true;
+    }
+
+    /**
+     * Finds an optimal solution of a 2x2x2, given by its stickers. At the end, each face
+     * has a single color, but the cube may be turned as a whole compared to the start.
+     *
+     * @return Returns false if the stickers do not describe a 2x2x2 that can be solved
+     */
+    bool solve(const FaceletCube& cube, std::vector<Move>& solution) const {
+        if (cube.size != 2) return false;
+        auto sticker = [&](int k) { return cube.at(Face(k / 9), k % 9 / 3 / 2, k % 3 / 2); };
+
+        // Rename the colors so that the corner in DBL is the DBL corner
+        const auto& dbl = CubeState::corner_facelets()[6];
+        uint8_t rename[6] = {0, 0, 0, 0, 0, 0};
+        for (int k = 0; k < 3; k++) {
+            Face face = Face(dbl[k] / 9), color = Face(sticker(dbl[k]));
+            rename[color] = face;
+            rename[opposite_face(color)] = opposite_face(face);
+        }
+        uint8_t stickers[54];
+        for (int i = 0; i < 54; i++) stickers[i] = i / 9;
+        for (const auto& c: CubeState::corner_facelets())
+            for (int k: c) stickers[k] = rename[sticker(k)];
+
+        CubeState s;
+        if (!CubeState::read_corners(stickers, s)) return false;
+        int twist = 0;
+        for (int i = 0; i < CubeState::CORNERS; i++) twist += s.co[i];
+        return twist % 3 == 0 && solve(s, solution);
+    }
+
+private:
+    SubgroupPattern pattern;
+    PatternDatabase table;
+    unsigned threads;
+    std::mutex loading;
+    std::atomic<bool> loaded{false};
+};
+
+#endif
@@ -0,0 +1,556 @@
+#ifndef REDUCTION_SOLVER_H
+#define REDUCTION_SOLVER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cubestate.cpp"
+#include "faceletcube.cpp"
+#include "twophase.cpp"
+
+/**
+ * Solver of NxNxN cubes by reduction: the centers are grouped and the edges paired, so that
+ * the cube can be turned like a 3x3x3 by its outer layers, and then solved as one.
+ *
+ * The pieces of a big cube fall into orbits: sets of 24 pieces that can take each other's
+ * places, and only these (e.g. the center pieces one step away from the corner of a face).
+ * Each orbit of centers or of edges ("wings") is solved with 3-cycles that move its pieces
+ * only, found once per size by searching commutators [A, B A' B'] and kept in a table, with
+ * up to two setup moves around them. As these 3-cycles leave everything else in place, the
+ * orbits do not depend on each other, and are solved in parallel.
+ *
+ * The parity cases of the reduction are avoided rather than fixed at the end:
+ *
+ *  - The edges of the 3x3x3 are chosen first (they are the middle edges of an odd cube). On an
+ *    even cube, they are chosen so that the reduced cube can be solved as a 3x3x3.
+ *  - An orbit of wings whose permutation is odd cannot be solved with 3-cycles: a quarter turn
+ *    of one of its inner slices is played first, before the centers are grouped.
+ *
+ * The 3x3x3 phase (Kociemba's two-phase algorithm) only depends on the corners and on the
+ * chosen edges, so it also runs in parallel with the orbits.
+ */
+class ReductionSolver {
+public:
+    ReductionSolver(unsigned _threads = std::thread::hardware_concurrency()) : threads(_threads ? _threads : 1) { }
+
+    /**
+     * Finds a solution of a cube. The solution is far from the shortest (hundreds of moves on
+     * a 7x7x7), as each 3-cycle takes 8 to 12 moves.
+     *
+     * @return Returns false if the facelets do not describe a cube that can be solved
+     */
+    bool solve(const FaceletCube& start, std::vector<LayerMove>& solution) {
+        solution.clear();
+        const int n = start.size;
+        const Tables& t = tables(n);
+        FaceletCube cube = start;
+
+        // Put the true centers of an odd cube back on their faces
+        if (n % 2 == 1 && n > 1) {
+            std::vector<int> path;
+            if (!center_orientation(t, cube, path)) return false;
+            for (int m: path) play(t, m, cube, solution);
+        }
+
+        // The 3x3x3 edges, as a state of the 3x3x3 together with the corners
+        CubeState reduced;
+        if (!choose_reduced_state(cube, reduced)) return false;
+        uint8_t stickers[54];
+        reduced.to_facelets(stickers);
+        // wanted[f][g]: color wanted on face f by the edge between f and g
+        uint8_t wanted[6][6] = {};
+        for (const auto& e: CubeState::edge_facelets()) {
+            wanted[e[0] / 9][e[1] / 9] = stickers[e[0]];
+            wanted[e[1] / 9][e[0] / 9] = stickers[e[1]];
+        }
+
+        // Fix the parity of the orbits of wings
+        for (const Orbit& o: t.orbits) {
+            if (!o.wing) continue;
+            std::vector<int> labels;
+            if (!wing_labels(o, cube, wanted, labels)) return false;
+            if (parity(labels)) play(t, move_id(n, FACE_U, o.layer, 1), cube, solution);
+        }
+
+        // Solve the orbits and the 3x3x3 in parallel: each task writes its own moves
+        std::vector<std::vector<int>> orbit_moves(t.orbits.size());
+        std::vector<Move> last_moves;
+        std::atomic<bool> ok(true);
+        std::vector<std::function<void()>> tasks;
+        tasks.push_back([&]() { if (!TwoPhaseSolver::instance().solve(reduced, last_moves)) ok = false; });
+        for (size_t i = 0; i < t.orbits.size(); i++) {
+            tasks.push_back([&, i]() {
+                const Orbit& o = t.orbits[i];
+                std::vector<int> labels, goals(o.slots.size());
+                if (o.wing) {
+                    if (!wing_labels(o, cube, wanted, labels)) { ok = false; return; }
+                    for (size_t s = 0; s < goals.size(); s++) goals[s] = s;
+                } else {
+                    for (size_t s = 0; s < goals.size(); s++) {
+                        labels.push_back(cube.facelets[o.slots[s]]);
+                        goals[s] = o.slots[s] / (n * n);
+                    }
+                }
+                if (!solve_orbit(o, labels, goals, orbit_moves[i])) ok = false;
+            });
+        }
+        run(tasks);
+        if (!ok) return false;
+
+        std::vector<LayerMove> moves = solution;
+        for (const auto& list: orbit_moves)
+            for (int m: list) moves.push_back(t.moves[m]);
+        for (Move m: last_moves) moves.push_back({move_face(m), 0, uint8_t(move_power(m))});
+        solution = simplify_layer_moves(moves, n);
+        return true;
+    }
+
+private:
+    /// A 3-cycle of the slots of an orbit (local indices): the piece in slots[0] goes to slots[1]...
+    struct Cycle {
+        std::array<uint8_t, 3> slots;
+        /// The moves (indices in `Tables::moves`)
+        std::vector<int> moves;
+    };
+
+    struct Orbit {
+        bool wing;
+        /// Inner layer containing the pieces of the orbit (for the wings)
+        int layer;
+        /// One facelet per piece
+        std::vector<int> slots;
+        /// For the wings: the other facelet of each slot
+        std::vector<int> partners;
+        /// All the known 3-cycles, at most one per cycle of slots
+        std::vector<Cycle> cycles;
+    };
+
+    /// Everything that only depends on the size of the cube
+    struct Tables {
+        std::vector<LayerMove> moves;
+        /// destination[m][i]: where the facelet at i goes with move m
+        std::vector<std::vector<int>> destination;
+        std::vector<Orbit> orbits;
+    };
+
+    unsigned threads;
+    std::mutex mutex;
+    std::map<int, std::unique_ptr<Tables>> cache;
+
+    /// Moves are indexed by axis (U, R, F), layer and power
+    static int move_id(int n, Face axis, int layer, int power) { return (axis * n + layer) * 3 + power - 1; }
+    static int inverse(int m) { return m - m % 3 + 2 - m % 3; }
+    static int axis_layer(int m) { return m / 3; }
+
+    static void play(const Tables& t, int m, FaceletCube& cube, std::vector<LayerMove>& moves) {
+        cube.turn(t.moves[m]);
+        moves.push_back(t.moves[m]);
+    }
+
+    /// Runs the tasks on the threads of the solver
+    void run(const std::vector<std::function<void()>>& tasks) {
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i; (i = next.fetch_add(1)) < tasks.size();) tasks[i]();
+        };
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads && i < tasks.size(); i++) pool.emplace_back(worker);
+        worker();
+        for (auto& th: pool) th.join();
+    }
+
+    static int parity(const std::vector<int>& p) {
+        std::vector<bool> seen(p.size(), false);
+        int result = 0;
+        for (size_t i = 0; i < p.size(); i++) {
+            if (seen[i]) continue;
+            for (size_t j = i; !seen[j]; j = p[j]) {
+                seen[j] = true;
+                result ^= (j != i);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Finds the slice turns (of the middle layers) bringing the true centers of an odd cube
+     * back to their faces, by iterative deepening.
+     */
+    static bool center_orientation(const Tables& t, const FaceletCube& cube, std::vector<int>& path) {
+        const int n = cube.size, mid = n / 2;
+        std::vector<int> centers(cube.facelets.size(), -1);
+        for (int f = 0; f < 6; f++) centers[cube.index(Face(f), mid, mid)] = cube.at(Face(f), mid, mid);
+        std::function<bool(std::vector<int>&, int, int)> search = [&](std::vector<int>& c, int togo, int last) {
+            bool solved = true;
+            for (int f = 0; f < 6; f++) solved &= c[cube.index(Face(f), mid, mid)] == f;
+            if (solved) return true;
+            if (togo == 0) return false;
+            for (int axis = 0; axis < 3; axis++) {
+                if (axis == last) continue;
+                for (int power = 1; power <= 3; power++) {
+                    int m = move_id(n, Face(axis), mid, power);
+                    std::vector<int> next(c.size(), -1);
+                    for (int f = 0; f < 6; f++) {
+                        int i = cube.index(Face(f), mid, mid);
+                        next[t.destination[m][i]] = c[i];
+                    }
+                    path.push_back(m);
+                    if (search(next, togo - 1, axis)) return true;
+                    path.pop_back();
+                }
+            }
+            return false;
+        };
+        for (int depth = 0; depth <= 3; depth++)
+            if (search(centers, depth, -1)) return true;
+        return false;
+    }
+
+    /**
+     * The state of the 3x3x3 the cube will be reduced to: its corners, and edges taken from
+     * the middle of the edges of an odd cube. An even cube has no such pieces: the wings
+     * next to the corners are used when they give distinct edges, and the edges are then
+     * completed so that the state can be solved.
+     */
+    static bool choose_reduced_state(const FaceletCube& cube, CubeState& s) {
+        const int n = cube.size, inner = n % 2 ? n / 2 : 1;
+        auto facelet = [&](int sticker) {
+            auto coordinate = [&](int x) { return x == 0 ? 0 : x == 2 ? n - 1 : inner; };
+            return cube.at(Face(sticker / 9), coordinate(sticker % 9 / 3), coordinate(sticker % 3));
+        };
+        uint8_t stickers[54];
+        for (int i = 0; i < 54; i++) stickers[i] = n > 2 ? facelet(i) : i / 9;
+        for (const auto& c: CubeState::corner_facelets())
+            for (int k: c) stickers[k] = facelet(k);
+        if (!CubeState::read_corners(stickers, s)) return false;
+        if (n % 2 == 1) return CubeState::read_edges(stickers, s) && s.is_valid();
+
+        bool used[CubeState::EDGES] = {};
+        std::vector<int> free_positions;
+        for (int i = 0; i < CubeState::EDGES; i++) {
+            const auto& e = CubeState::edge_facelets()[i];
+            int j = n > 2 ? CubeState::find_edge(stickers[e[0]], stickers[e[1]], s.eo[i]) : -1;
+            if (j < 0 || used[j]) {
+                free_positions.push_back(i);
+                continue;
+            }
+            used[j] = true;
+            s.ep[i] = j;
+        }
+        for (int i: free_positions) {
+            int j = 0;
+            while (used[j]) j++;
+            used[j] = true;
+            s.ep[i] = j;
+            s.eo[i] = 0;
+        }
+        if (s.edge_parity() != s.corner_parity()) std::swap(s.ep[0], s.ep[1]);
+        int flip = 0;
+        for (int i = 0; i < CubeState::EDGES; i++) flip += s.eo[i];
+        if (flip % 2) s.eo[0] ^= 1;
+        return true;
+    }
+
+    /**
+     * Labels the pieces of an orbit of wings with the slot they must go to, given the colors
+     * wanted on each edge.
+     */
+    static bool wing_labels(const Orbit& o, const FaceletCube& cube, const uint8_t wanted[6][6], std::vector<int>& labels) {
+        const int area = cube.size * cube.size;
+        int slot_of[6][6];
+        for (auto& row: slot_of) std::fill(row, row + 6, -1);
+        for (size_t s = 0; s < o.slots.size(); s++) {
+            int f = o.slots[s] / area, g = o.partners[s] / area;
+            slot_of[wanted[f][g]][wanted[g][f]] = s;
+        }
+        labels.resize(o.slots.size());
+        std::vector<bool> taken(o.slots.size(), false);
+        for (size_t s = 0; s < o.slots.size(); s++) {
+            int l = slot_of[cube.facelets[o.slots[s]]][cube.facelets[o.partners[s]]];
+            if (l < 0 || taken[l]) return false;
+            taken[l] = true;
+            labels[s] = l;
+        }
+        return true;
+    }
+
+    /// @return Returns the number of pieces a 3-cycle puts in place, minus the ones it takes out
+    static int gain(const Cycle& c, const std::vector<int>& labels, const std::vector<int>& goals) {
+        const auto& s = c.slots;
+        // The piece of s[0] goes to s[1], the one of s[1] to s[2], the one of s[2] to s[0]
+        return (labels[s[0]] == goals[s[1]]) + (labels[s[1]] == goals[s[2]]) + (labels[s[2]] == goals[s[0]])
+            - (labels[s[0]] == goals[s[0]]) - (labels[s[1]] == goals[s[1]]) - (labels[s[2]] == goals[s[2]]);
+    }
+
+    static void apply(const Cycle& c, std::vector<int>& labels) {
+        const auto& s = c.slots;
+        int last = labels[s[2]];
+        labels[s[2]] = labels[s[1]];
+        labels[s[1]] = labels[s[0]];
+        labels[s[0]] = last;
+    }
+
+    /**
+     * Solves an orbit greedily: plays the known 3-cycle putting the most pieces in place,
+     * until all are. `labels` are the pieces in each slot, `goals` the wanted ones (several
+     * slots may want the same label, e.g. a color of centers).
+     *
+     * A few cycles are not in the table: when no single 3-cycle helps, two are played.
+     */
+    static bool solve_orbit(const Orbit& o, std::vector<int> labels, const std::vector<int>& goals,
+                            std::vector<int>& moves) {
+        auto best_cycle = [&](const std::vector<int>& l, int& best_gain) {
+            const Cycle* best = nullptr;
+            best_gain = 0;
+            for (const Cycle& c: o.cycles) {
+                int g = gain(c, l, goals);
+                if (g > best_gain || (g == best_gain && best && c.moves.size() < best->moves.size())) {
+                    best = &c;
+                    best_gain = g;
+                }
+            }
+            return best;
+        };
+        auto play = [&](const Cycle& c) {
+            apply(c, labels);
+            moves.insert(moves.end(), c.moves.begin(), c.moves.end());
+        };
+
+        while (labels != goals) {
+            int g;
+            if (const Cycle* c = best_cycle(labels, g)) {
+                play(*c);
+                continue;
+            }
+            const Cycle *first = nullptr, *second = nullptr;
+            for (const Cycle& c: o.cycles) {
+                std::vector<int> next = labels;
+                apply(c, next);
+                const Cycle* d = best_cycle(next, g);
+                if (d && g + gain(c, labels, goals) > 0) {
+                    first = &c;
+                    second = d;
+                    break;
+                }
+            }
+            if (!first) break;
+            play(*first);
+            play(*second);
+        }
+        for (size_t s = 0; s < labels.size(); s++)
+            if (labels[s] != goals[s]) return false;
+        return true;
+    }
+
+    const Tables& tables(int n) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unique_ptr<Tables>& t = cache[n];
+        if (!t) t = build_tables(n);
+        return *t;
+    }
+
+    std::unique_ptr<Tables> build_tables(int n) {
+        std::unique_ptr<Tables> t(new Tables);
+        FaceletCube cube(n);
+        const int count = cube.facelets.size();
+
+        // The permutation of the facelets of each move
+        std::vector<std::vector<int>> support;
+        for (int axis = 0; axis < 3; axis++) {
+            for (int layer = 0; layer < n; layer++) {
+                for (int power = 1; power <= 3; power++) {
+                    std::vector<int> labels(count);
+                    for (int i = 0; i < count; i++) labels[i] = i;
+                    cube.permute(labels, Face(axis), layer, power);
+                    std::vector<int> destination(count), moved;
+                    for (int i = 0; i < count; i++) {
+                        destination[labels[i]] = i;
+                        if (labels[i] != i) moved.push_back(i);
+                    }
+                    t->moves.push_back({Face(axis), uint8_t(layer), uint8_t(power)});
+                    t->destination.push_back(destination);
+                    support.push_back(moved);
+                }
+            }
+        }
+
+        // The orbits of facelets (union-find over the quarter turns)
+        std::vector<int> root(count);
+        for (int i = 0; i < count; i++) root[i] = i;
+        std::function<int(int)> find = [&](int i) { return root[i] == i ? i : root[i] = find(root[i]); };
+        for (size_t m = 0; m < t->moves.size(); m += 3)
+            for (int i: support[m]) root[find(i)] = find(t->destination[m][i]);
+
+        // Keep the centers (but the true centers), and one of the two facelet orbits of each
+        // orbit of wings (but the middle edges)
+        std::vector<int> orbit_of(count, -1);
+        std::map<int, int> orbit_of_root;
+        const int area = n * n;
+        for (int i = 0; i < count; i++) {
+            int row = i % area / n, col = i % n;
+            bool row_inner = row > 0 && row < n - 1, col_inner = col > 0 && col < n - 1;
+            if (!row_inner && !col_inner) continue;
+            bool wing = !row_inner || !col_inner;
+            int k = row_inner ? row : col;
+            if (n % 2 == 1 && (wing ? k == n / 2 : row == n / 2 && col == n / 2)) continue;
+            if (wing && find(i) > find(cube.partner(i))) continue;
+            auto it = orbit_of_root.find(find(i));
+            if (it == orbit_of_root.end()) {
+                it = orbit_of_root.emplace(find(i), t->orbits.size()).first;
+                t->orbits.push_back({wing, std::min(k, n - 1 - k), {}, {}, {}});
+            }
+            Orbit& o = t->orbits[it->second];
+            o.slots.push_back(i);
+            if (wing) o.partners.push_back(cube.partner(i));
+            orbit_of[i] = it->second;
+        }
+
+        // The commutators [A, B A' B'] moving 3 pieces of one orbit only, with A an inner
+        // slice and B = F X F' (F an outer layer, X any layer of another axis)
+        std::vector<std::vector<Cycle>> base(t->orbits.size());
+        std::vector<int> stamp(count, -1), touched;
+        int candidate = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            for (int layer = 1; layer < n - 1; layer++) {
+                int a = move_id(n, Face(axis), layer, 1);
+                for (int f = 0; f < 3 * n * 3; f++) {
+                    int f_layer = t->moves[f].layer;
+                    if (f_layer != 0 && f_layer != n - 1) continue;
+                    for (int x = 0; x < 3 * n * 3; x++) {
+                        if (t->moves[x].face == t->moves[f].face || t->moves[x].power == 2) continue;
+                        const std::array<int, 8> sequence = {a, f, x, inverse(f), inverse(a), f, inverse(x), inverse(f)};
+                        // Only the facelets moved by A or by B can move
+                        candidate++;
+                        touched.clear();
+                        for (int i: support[a]) { stamp[i] = candidate; touched.push_back(i); }
+                        for (int i: support[x]) {
+                            int j = t->destination[inverse(f)][i];
+                            if (stamp[j] != candidate) { stamp[j] = candidate; touched.push_back(j); }
+                        }
+                        int moved[7], moved_count = 0, destination[7];
+                        for (int i: touched) {
+                            int p = i;
+                            for (int m: sequence) p = t->destination[m][p];
+                            if (p == i) continue;
+                            if (moved_count == 7) break;
+                            destination[moved_count] = p;
+                            moved[moved_count++] = i;
+                        }
+                        add_cycle(*t, cube, orbit_of, moved, destination, moved_count, sequence, base);
+                    }
+                }
+            }
+        }
+
+        // Conjugate them with up to two setup moves, in parallel over the orbits
+        std::vector<std::function<void()>> tasks;
+        for (size_t i = 0; i < t->orbits.size(); i++)
+            tasks.push_back([&, i]() { conjugate(*t, support, t->orbits[i], base[i]); });
+        run(tasks);
+        return t;
+    }
+
+    /**
+     * Adds a commutator to the 3-cycles of an orbit if it moves exactly 3 of its pieces
+     * (3 facelets of centers, or 3 wings and their partners).
+     */
+    static void add_cycle(const Tables& t, const FaceletCube& cube, const std::vector<int>& orbit_of,
+                          const int* moved, const int* destination, int count, const std::array<int, 8>& sequence,
+                          std::vector<std::vector<Cycle>>& base) {
+        if (count != 3 && count != 6) return;
+        int slots[3], slot_count = 0;
+        for (int k = 0; k < count; k++)
+            if (orbit_of[moved[k]] >= 0 && slot_count < 3) slots[slot_count++] = k;
+        if (slot_count != 3) return;
+        int o = orbit_of[moved[slots[0]]];
+        const Orbit& orbit = t.orbits[o];
+        if (orbit_of[moved[slots[1]]] != o || orbit_of[moved[slots[2]]] != o) return;
+        if (orbit.wing != (count == 6)) return;
+        if (orbit.wing) {
+            // The other 3 facelets must be the partners of the 3 wings
+            for (int k = 0; k < count; k++) {
+                bool found = false;
+                for (int s: slots) found |= moved[k] == moved[s] || moved[k] == cube.partner(moved[s]);
+                if (!found) return;
+            }
+        }
+        auto local = [&](int facelet) {
+            return uint8_t(std::find(orbit.slots.begin(), orbit.slots.end(), facelet) - orbit.slots.begin());
+        };
+        Cycle c;
+        c.slots[0] = local(moved[slots[0]]);
+        c.slots[1] = local(destination[slots[0]]);
+        for (int s: slots)
+            if (moved[s] == destination[slots[0]]) c.slots[2] = local(destination[s]);
+        c.moves.assign(sequence.begin(), sequence.end());
+        base[o].push_back(c);
+    }
+
+    /**
+     * Builds the 3-cycles of an orbit: the commutators found for it, their inverses, and both
+     * conjugated by up to two setup moves (S C S'), keeping the shortest for each cycle.
+     */
+    static void conjugate(const Tables& t, const std::vector<std::vector<int>>& support, Orbit& o,
+                          const std::vector<Cycle>& base) {
+        const int size = o.slots.size();
+        std::vector<int> local(t.destination[0].size(), -1);
+        for (int s = 0; s < size; s++) local[o.slots[s]] = s;
+
+        std::vector<Cycle> cycles;
+        for (const Cycle& c: base) {
+            cycles.push_back(c);
+            Cycle inv;
+            inv.slots = {c.slots[0], c.slots[2], c.slots[1]};
+            for (auto it = c.moves.rbegin(); it != c.moves.rend(); ++it) inv.moves.push_back(inverse(*it));
+            cycles.push_back(inv);
+        }
+
+        // The setup moves worth trying are the ones moving pieces of the orbit
+        std::vector<int> setups;
+        for (size_t m = 0; m < t.moves.size(); m++)
+            for (int i: support[m])
+                if (local[i] >= 0) { setups.push_back(m); break; }
+
+        // The setups are tried by increasing length, so the first cycle found is the shortest
+        std::vector<bool> known(size * size * size, false);
+        auto add = [&](const Cycle& c, const int* setup, int length) {
+            // S C S' moves the pieces that S brings onto the slots of C
+            std::array<uint8_t, 3> slots;
+            for (int k = 0; k < 3; k++) {
+                int p = o.slots[c.slots[k]];
+                for (int i = length - 1; i >= 0; i--) p = t.destination[inverse(setup[i])][p];
+                slots[k] = local[p];
+            }
+            std::rotate(slots.begin(), std::min_element(slots.begin(), slots.end()), slots.end());
+            int key = (slots[0] * size + slots[1]) * size + slots[2];
+            if (known[key]) return;
+            known[key] = true;
+            Cycle conjugated;
+            conjugated.slots = slots;
+            conjugated.moves.assign(setup, setup + length);
+            conjugated.moves.insert(conjugated.moves.end(), c.moves.begin(), c.moves.end());
+            for (int i = length - 1; i >= 0; i--) conjugated.moves.push_back(inverse(setup[i]));
+            o.cycles.push_back(conjugated);
+        };
+        for (const Cycle& c: cycles) add(c, nullptr, 0);
+        for (const Cycle& c: cycles)
+            for (int m: setups) add(c, &m, 1);
+        for (const Cycle& c: cycles)
+            for (int m1: setups)
+                for (int m2: setups)
+                    if (axis_layer(m1) != axis_layer(m2)) {
+                        int setup[2] = {m1, m2};
+                        add(c, setup, 2);
+                    }
+    }
+};
+
+#endif
@@ -1,12 +1,21 @@
+#ifndef RUBICSCUBE_H
+#define RUBICSCUBE_H
+
 #include <vector>
 #include <array>
+#include <deque>
+#include <map>
 #include <iostream>
+#include <cmath>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include "cubestate.cpp"
+#include "faceletcube.cpp"
+
 using glm::vec3;
 using std::cout;
 using std::endl;
@@ -28,13 +37,15 @@ public:
   explicit operator bool() const = delete;        
   constexpr bool operator==(Color a) const { return value == a.value; }
   constexpr bool operator!=(Color a) const { return value != a.value; }
+  constexpr bool operator==(Value a) const { return value == a; }
+  constexpr bool operator!=(Value a) const { return value != a; }
 
   /**
-   * Returns the position of the center associated with this color.
+   * Returns the axis of the face of this color, pointing outside of the cube.
    * 
-   * As it happens, the rotation axis of each face is also the position
+   * As it happens, the rotation axis of each face is also the position of its center on a 3x3x3
    */
-  vec3 center_position() const {
+  vec3 axis() const {
     switch (value)
     {
     case WHITE: return vec3(0., 0., 1.0);
@@ -47,6 +58,56 @@ public:
     }
   }
 
+  /**
+   * Returns the color of the face whose axis is the closest to the given direction
+   */
+  static Color of_axis(vec3 direction) {
+    const Color all[6] = {WHITE, RED, YELLOW, ORANGE, GREEN, BLUE};
+    Color best = WHITE;
+    for (Color c: all)
+      if (glm::dot(c.axis(), direction) > glm::dot(best.axis(), direction)) best = c;
+    return best;
+  }
+
+  /**
+   * Returns the position of the center associated with this color, on a cube of the given size
+   * (the cubes are 1 unit wide, and the rubicscube is centered on the origin).
+   */
+  vec3 center_position(int size = 3) const {
+    return axis() * ((size - 1) / 2.0f);
+  }
+
+  /**
+   * Returns the color of a face of the logical model (see `cubestate.cpp`)
+   */
+  static Color of_face(Face f) {
+    switch (f)
+    {
+    case FACE_U: return ORANGE;
+    case FACE_R: return BLUE;
+    case FACE_F: return WHITE;
+    case FACE_D: return RED;
+    case FACE_L: return GREEN;
+    case FACE_B: return YELLOW;
+    }
+    return NONE;
+  }
+
+  /**
+   * Returns the face of the logical model with this color
+   */
+  Face face() const {
+    switch (value)
+    {
+    case ORANGE: return FACE_U;
+    case BLUE: return FACE_R;
+    case WHITE: return FACE_F;
+    case RED: return FACE_D;
+    case GREEN: return FACE_L;
+    default: return FACE_B;
+    }
+  }
+
   /**
    * Returns the (R)ight and (U)p neighor face.
    */
@@ -160,10 +221,32 @@ class Cube {
             transform = rotate(transform, radians(_theta), vec3(0., 0., 1.));
         }
 
+        /**
+         * Sets the rotation of the cube so that its front face looks toward `front`, and its
+         * right face toward `right`.
+         */
+        void orient(vec3 front, vec3 right) {
+            transform[0] = vec4(right, 0.);
+            transform[1] = vec4(cross(front, right), 0.);
+            transform[2] = vec4(front, 0.);
+        }
+
         void apply(const mat4& transformation) {
             this->transform = transformation * this->transform;
         }
 
+        /**
+         * Removes the rounding errors of the rotations: the axes of the cube are along the
+         * axes of the world, and its center is at an integer or half-integer position.
+         */
+        void snap() {
+            for (int c = 0; c < 3; c++)
+                for (int r = 0; r < 3; r++)
+                    transform[c][r] = std::round(transform[c][r]);
+            for (int r = 0; r < 3; r++)
+                transform[3][r] = std::round(transform[3][r] * 2.0f) / 2.0f;
+        }
+
         /**
          * Fills inplace the array with the colors of the Front, Right & Top colors
          */
@@ -180,141 +263,152 @@ class Cube {
 
 
 /**
- * The model for a rubicscube is simply a list of cubes...
- * 
- * The constructor of this class instantiates all the 26 cubes with their right color and their right positions/orientation.
+ * The turns played on a cube, for undo and redo.
+ *
+ * The first `position()` turns are applied; the ones after were undone, and can be redone
+ * until a new turn is played. Copies of the whole cube (checkpoints) are kept every
+ * `interval` turns, and at each position jumped from: going back or forward by any number
+ * of turns restores the closest copy and replays only the turns between it and the target.
  */
-class RubicsCube {
-    public:
+class MoveJournal {
+public:
+    struct Checkpoint {
         std::vector<Cube> cubes;
-        Color current_face = Color::WHITE;
-
-        RubicsCube() {
-            // CENTERS
-
-            // White
-            cubes.push_back(Cube(vec3(0., 0., 1.), Color::WHITE));
-            cubes.back().set_center();
-
-            // Orange
-            cubes.push_back(Cube(vec3(0., 1., 0.), Color::ORANGE));
-            cubes.back().rotate_x(-90.0f);
-            cubes.back().set_center();
-
-            // Red
-            cubes.push_back(Cube(vec3(0., -1., 0.), Color::RED));
-            cubes.back().rotate_x(90.0f);
-            cubes.back().set_center();
-
-            // Blue
-            cubes.push_back(Cube(vec3(1., 0., 0.), Color::BLUE));
-            cubes.back().rotate_y(90.0f);
-            cubes.back().set_center();
-
-            // Green
-            cubes.push_back(Cube(vec3(-1., 0., 0.), Color::GREEN));
-            cubes.back().rotate_y(-90.0f);
-            cubes.back().set_center();
+        std::vector<uint8_t> facelets;
+    };
 
-            // Yellow
-            cubes.push_back(Cube(vec3(0., 0., -1.), Color::YELLOW));
-            cubes.back().rotate_y(-180.0f);
-            cubes.back().set_center();
+    MoveJournal(size_t _interval = 32, std::vector<LayerMove> _turns = {})
+        : interval(_interval), turns(std::move(_turns)), applied(turns.size()) { }
 
-            // 1. WHITE FACE
+    /// @return Returns all the turns, including the ones undone
+    const std::vector<LayerMove>& moves() const { return turns; }
 
-            // Left 
-            cubes.push_back(Cube(vec3(-1., 0., 1.), Color::WHITE, Color::GREEN));
-            cubes.back().swap_x();
+    /// @return Returns the number of turns applied
+    size_t position() const { return applied; }
 
-            // Right
-            cubes.push_back(Cube(vec3(1., 0., 1.), Color::WHITE, Color::BLUE));
+    bool can_undo() const { return applied > 0; }
+    bool can_redo() const { return applied < turns.size(); }
 
-            // Top
-            cubes.push_back(Cube(vec3(0., 1., 1.), Color::WHITE, Color::ORANGE));
-            cubes.back().rotate_z(90.0f);
-
-            // Bottom
-            cubes.push_back(Cube(vec3(0., -1., 1.), Color::WHITE, Color::RED));
-            cubes.back().rotate_z(-90.0f);
-
-            // Top-Right
-            cubes.push_back(Cube(vec3(1., 1., 1.), Color::WHITE, Color::BLUE, Color::ORANGE));
-
-            // Top-left
-            cubes.push_back(Cube(vec3(-1., 1., 1.), Color::WHITE, Color::GREEN, Color::ORANGE));
-            cubes.back().swap_x();
-
-            // Bottom Right
-            cubes.push_back(Cube(vec3(1., -1., 1.), Color::WHITE, Color::BLUE, Color::RED));
-
-            // Bottom Left
-            cubes.push_back(Cube(vec3(-1., -1., 1.), Color::WHITE, Color::GREEN, Color::RED));
-            cubes.back().swap_x();
-            
-            // BLUE FACE
-
-            // Botto
-            cubes.push_back(Cube(vec3(1., -1., 0.), Color::BLUE, Color::RED));
-            cubes.back().rotate_y(90.0f);
-            cubes.back().rotate_z(-90.0f);
+    /// Adds a new turn: the turns undone cannot be redone anymore
+    void record(const LayerMove& m) {
+        turns.resize(applied);
+        checkpoints.erase(checkpoints.upper_bound(applied), checkpoints.end());
+        turns.push_back(m);
+        applied++;
+    }
 
-            // Right
-            cubes.push_back(Cube(vec3(1., 0., -1.), Color::BLUE, Color::YELLOW));
-            cubes.back().rotate_y(90.0f);
+    /// @return Returns the turn that undoes the last turn applied
+    LayerMove undo() { return turns[--applied].inverse(); }
 
-            // Top-Right
-            cubes.push_back(Cube(vec3(1., 1., -1.), Color::BLUE, Color::YELLOW, Color::ORANGE));
-            cubes.back().rotate_y(90.0f);
+    /// @return Returns the next turn to apply again
+    LayerMove redo() { return turns[applied++]; }
 
-            // Bottom-Right
-            cubes.push_back(Cube(vec3(1., -1., -1.), Color::BLUE, Color::YELLOW, Color::RED));
-            cubes.back().rotate_y(90.0f);
+    bool has_checkpoint() const { return checkpoints.count(applied) > 0; }
 
-            // GREEN FACE
+    /// @return Returns true if a copy of the cube should be kept at the current position
+    bool is_checkpoint_due() const { return applied % interval == 0 && !has_checkpoint(); }
 
-            // Bottom
-            cubes.push_back(Cube(vec3(-1., -1., 0.), Color::GREEN, Color::RED));
-            cubes.back().rotate_y(-90.0f);
-            cubes.back().rotate_z(-90.0f);
+    /// Keeps a copy of the cube at the current position
+    void add_checkpoint(const std::vector<Cube>& cubes, const std::vector<uint8_t>& facelets) {
+        checkpoints[applied] = {cubes, facelets};
+    }
 
-            // Left
-            cubes.push_back(Cube(vec3(-1., 0., -1.), Color::GREEN, Color::YELLOW));
-            cubes.back().rotate_y(-90.0f);
-            cubes.back().swap_x();
+    /**
+     * Moves the journal to `target` turns applied. The cube is then the returned checkpoint
+     * followed by the turns of `replay`.
+     * @return Returns null if there is no checkpoint
+     */
+    const Checkpoint* seek(size_t target, std::vector<LayerMove>& replay) {
+        replay.clear();
+        if (checkpoints.empty() || target > turns.size()) return nullptr;
+        auto next = checkpoints.lower_bound(target);
+        auto closest = next;
+        if (next == checkpoints.end() || (next != checkpoints.begin() && target - std::prev(next)->first < next->first - target))
+            closest = std::prev(next);
+
+        size_t from = closest->first;
+        for (size_t k = from; k < target; k++) replay.push_back(turns[k]);
+        for (size_t k = from; k > target; k--) replay.push_back(turns[k - 1].inverse());
+        applied = target;
+        return &closest->second;
+    }
 
-            // Top-Left
-            cubes.push_back(Cube(vec3(-1., 1., -1.), Color::GREEN, Color::YELLOW, Color::ORANGE));
-            cubes.back().rotate_y(-90.0f);
-            cubes.back().swap_x();
+private:
+    size_t interval;
+    std::vector<LayerMove> turns;
+    size_t applied;
+    /// Copies of the cube, by number of turns applied
+    std::map<size_t, Checkpoint> checkpoints;
+};
 
-            // Bottom-Left
-            cubes.push_back(Cube(vec3(-1., -1., -1.), Color::GREEN, Color::YELLOW, Color::RED));
-            cubes.back().rotate_y(-90.0f);
-            cubes.back().swap_x();
-
-            // YELLOW FACE
-
-            // Top
-            cubes.push_back(Cube(vec3(0., 1., -1.), Color::YELLOW, Color::ORANGE));
-            cubes.back().rotate_y(-180.0f);
-            cubes.back().rotate_z(90.0f);
-
-            // Bottom
-            cubes.push_back(Cube(vec3(0., -1., -1.), Color::YELLOW, Color::RED));
-            cubes.back().rotate_y(-180.0f);
-            cubes.back().rotate_z(-90.0f);
+/**
+ * The model for a rubicscube is simply a list of cubes...
+ * 
+ * The constructor of this class instantiates the cubes of the surface of a NxNxN rubicscube
+ * (6 N^2 - 12 N + 8 of them) with their right color and their right positions/orientation.
+ */
+class RubicsCube {
+    public:
+        /// Number of cubes along an edge
+        int size;
+        std::vector<Cube> cubes;
+        Color current_face = Color::WHITE;
+        /// Layer moved by the keyboard, 0 being the face itself (for cubes bigger than 3x3x3)
+        int current_layer = 0;
+        /// Logical state of the stickers, kept in sync with the cubes by `RotationManager`
+        FaceletCube facelets;
+        /// The turns played, for undo and redo (kept by `RotationManager`)
+        MoveJournal journal;
+
+        RubicsCube(int _size = 3) : size(_size), facelets(_size), journal(checkpoint_interval(_size)) {
+            // The colors, in the order they are given to the front, right and top faces of a cube
+            const Color order[6] = {Color::WHITE, Color::YELLOW, Color::BLUE, Color::GREEN, Color::ORANGE, Color::RED};
+            const float h = half_size();
+
+            for (int i = 0; i < size; i++) {
+                for (int j = 0; j < size; j++) {
+                    for (int k = 0; k < size; k++) {
+                        // Only the cubes of the surface are visible
+                        if (i != 0 && i != size - 1 && j != 0 && j != size - 1 && k != 0 && k != size - 1) continue;
+                        vec3 pos(i - h, j - h, k - h);
+
+                        // The faces of the rubicscube this cube belongs to
+                        Color colors[3] = {Color::NONE, Color::NONE, Color::NONE};
+                        int n = 0;
+                        for (Color c: order)
+                            if (glm::dot(pos, c.axis()) > h - 0.25f) colors[n++] = c;
+
+                        if (n == 1) {
+                            cubes.push_back(Cube(pos, colors[0]));
+                            cubes.back().set_center();
+                        } else if (n == 2) {
+                            cubes.push_back(Cube(pos, colors[0], colors[1]));
+                        } else {
+                            cubes.push_back(Cube(pos, colors[0], colors[1], colors[2]));
+                        }
+
+                        // Front shows the first color, right the second one. The third color is
+                        // drawn on both the top and bottom faces, so it is visible either way.
+                        vec3 front = colors[0].axis();
+                        vec3 right = n >= 2 ? colors[1].axis() : perpendicular(front);
+                        cubes.back().orient(front, right);
+                    }
+                }
+            }
+        }
 
-            // 2. ORANGE FACE 
-
-            // Right
-            cubes.push_back(Cube(vec3(1., 1., 0.), Color::ORANGE, Color::BLUE));
-            cubes.back().rotate_x(-90.0f);
+        /**
+         * Restores a cube from its saved parts (see `session.cpp`), without placing the cubes
+         * again: `_cubes` holds their transforms and colors, `_facelets` the 6 N^2 stickers.
+         */
+        RubicsCube(int _size, std::vector<Cube> _cubes, const uint8_t* _facelets, std::vector<LayerMove> _history)
+            : size(_size), cubes(std::move(_cubes)), facelets(_size), journal(checkpoint_interval(_size), std::move(_history)) {
+            facelets.facelets.assign(_facelets, _facelets + facelets.facelets.size());
+        }
 
-            // Left
-            cubes.push_back(Cube(vec3(-1., 1., 0.), Color::ORANGE, Color::GREEN));
-            cubes.back().rotate_x(-90.0f);
-            cubes.back().swap_x();
+        /// @return Returns the coordinate of the outer layers along any axis
+        float half_size() const {
+            return (size - 1) / 2.0f;
         }
 
         void set_main_color(Color _c) {
@@ -322,18 +416,27 @@ class RubicsCube {
         }
 
         /**
-         * Returns true if the cube is on the main face.
+         * Returns true if the cube is a center of the main face (found by its position: the
+         * centers of the big cubes move with the inner layers).
          */
         bool is_cube_on_selected_face(const Cube& c) const {
-            // TODO this method does not work.
-            //      the best thing to do would be to use an attribute on each cube.
-            return c.color1 == current_face && c.is_center;
+            return c.is_center && glm::dot(c.position(), current_face.axis()) > half_size() - 0.25f;
         }
 
     private:
         // The current face is the color of the center.
         Color selected_face = Color::WHITE;
 
+        /// Turns between two copies of the cube in the journal: more on the big cubes, whose copies are big
+        static size_t checkpoint_interval(int size) {
+            return std::max(32, size * size);
+        }
+
+        /// @return Returns an axis perpendicular to the given one
+        static vec3 perpendicular(vec3 axis) {
+            return std::abs(axis.x) > 0.5f ? vec3(0., 0., 1.) : vec3(1., 0., 0.);
+        }
+
 };
 
 
@@ -350,28 +453,136 @@ public:
         angular_step = radians(5.0f);
     }
 
-    bool is_free() {return !is_running;} 
+    bool is_free() {return !is_running && queue.empty();} 
+
+    /**
+     * Returns true if the cube is in the layer being turned (its depth along the axis of the
+     * turn does not change while it turns).
+     */
+    bool is_turning(vec3 position) const {
+        return is_running && std::abs(glm::dot(rotation_axis, position) - layer_depth) < 0.25f;
+    }
 
     void step() {
+        if (!is_running && !queue.empty()) {
+            LayerMove m = queue.front();
+            queue.pop_front();
+            start_move(m);
+        }
         if (is_running && remaining_angle > angular_step) {
             remaining_angle -= angular_step;
             for (const auto& i: indices) 
                 game->cubes[i].apply(current_transform);
         } else if (is_running) {
-            is_running = false;
+            end_move();
+            keep_checkpoint();
+        }
+    }
+
+    /// Ends the current move and plays the waiting ones at once, without animation
+    void finish() {
+        while (!is_free()) {
+            if (!is_running) {
+                start_move(queue.front());
+                queue.pop_front();
+            }
+            complete_move();
+            keep_checkpoint();
         }
     }
 
+    /**
+     * Undoes the last turn (animated).
+     * @return Returns false if a move is in progress, or if there is nothing to undo
+     */
+    bool undo() {
+        if (!is_free() || !game->journal.can_undo()) return false;
+        start_move(game->journal.undo(), false);
+        return true;
+    }
+
+    /**
+     * Plays again the last turn undone (animated).
+     * @return Returns false if a move is in progress, or if there is nothing to redo
+     */
+    bool redo() {
+        if (!is_free() || !game->journal.can_redo()) return false;
+        start_move(game->journal.redo(), false);
+        return true;
+    }
+
+    /**
+     * Goes back or forward at once to the cube with `position` turns applied: the closest
+     * copy of the cube in the journal is restored, and the few turns between it and the
+     * target are played without animation.
+     * @return Returns false if a move is in progress, or if there is no such position
+     */
+    bool jump_to(size_t position) {
+        MoveJournal& journal = game->journal;
+        if (!is_free() || position > journal.moves().size()) return false;
+        if (!journal.has_checkpoint()) journal.add_checkpoint(game->cubes, game->facelets.facelets);
+
+        std::vector<LayerMove> replay;
+        const MoveJournal::Checkpoint* checkpoint = journal.seek(position, replay);
+        game->cubes = checkpoint->cubes;
+        game->facelets.facelets = checkpoint->facelets;
+        for (const LayerMove& m: replay) {
+            start_move(m, false);
+            complete_move();
+        }
+        keep_checkpoint();
+        return true;
+    }
+
+    /**
+     * Adds moves to play after the current one.
+     * 
+     * The moves still waiting are simplified together with the new ones, so that no frame
+     * is spent on moves that cancel each other.
+     */
+    void queue_moves(const std::vector<LayerMove>& moves) {
+        std::vector<LayerMove> pending(queue.begin(), queue.end());
+        pending.insert(pending.end(), moves.begin(), moves.end());
+        pending = simplify_layer_moves(pending, game->size);
+        queue.assign(pending.begin(), pending.end());
+    }
+
+    /// @return Returns the number of moves waiting (not started yet)
+    size_t waiting_moves() const { return queue.size(); }
+
+    /// Replaces the moves waiting: the current one, if any, goes on
+    void replace_waiting_moves(const std::vector<LayerMove>& moves) { queue.assign(moves.begin(), moves.end()); }
+
+    /// Adds moves of the 3x3x3 notation (outer layers)
+    void queue_moves(const std::vector<Move>& moves) {
+        std::vector<LayerMove> layer_moves;
+        for (Move m: moves) layer_moves.push_back({move_face(m), 0, uint8_t(move_power(m))});
+        queue_moves(layer_moves);
+    }
+
+    /**
+     * Starts a move of the logical model, whatever the selected face.
+     */
+    void start_move(Move m) {
+        // Clockwise seen from outside the face is a negative angle around its axis
+        int power = move_power(m);
+        start_rotation(Color::of_face(move_face(m)), 0, power == 3, power == 2 ? 180.f : 90.f);
+    }
+
+    /**
+     * Starts a move of any layer (for cubes bigger than 3x3x3).
+     * @param record Whether the move is a new turn of the journal (not an undo or a redo)
+     */
+    void start_move(const LayerMove& m, bool record = true) {
+        start_rotation(Color::of_face(m.face), m.layer, m.power == 3, m.power == 2 ? 180.f : 90.f, record);
+    }
+
     /**
      * Apply a rubicscube motion.
      * 
      * This function does the required computing to configure the motion.
      */
     void start_motion(Motion m, bool forward) {
-        // Re-init different values
-        is_running = true;
-        remaining_angle = radians(90.f);
-
         // Find the color of the face that will be rotated
         Color main_color = game->current_face;
         std::array<Color, 2> others = main_color.neighbors();
@@ -388,25 +599,63 @@ public:
             rotated_color = others[1];
             break;
         }
+        start_rotation(rotated_color, game->current_layer, forward, 90.f);
+    }
 
-        // Find the indices of the cube on the rotating frame.
-        // Go Through all cubes and find those that have a distance of 1.0 with the main face
-        indices = {};
-        vec3 center_pos = rotated_color.center_position();
-        for (uint j = 0; j < game->cubes.size(); j++) {
-            float distance = glm::length(center_pos - game->cubes[j].position());
-            if (distance < 1.5f) {
-                // Skip other centers, as they also pass the previous geometrical rule
-                if (distance > 0.01f && game->cubes[j].is_center) continue;
-                indices.push_back(j);
+    private:
+        /**
+         * Configures the rotation of a layer by a given angle (in degrees).
+         * `forward` rotates counter-clockwise, seen from outside the face.
+         */
+        void start_rotation(Color rotated_color, int layer, bool forward, float angle, bool record = true) {
+            // Re-init different values
+            is_running = true;
+            remaining_angle = radians(angle);
+
+            // Find the indices of the cube on the rotating layer.
+            // Go Through all cubes and find those whose depth along the axis is the one of the layer.
+            // Only the cubes of the surface exist, so this is O(N^2).
+            indices = {};
+            vec3 axis = rotated_color.axis();
+            float depth = game->half_size() - layer;
+            for (uint j = 0; j < game->cubes.size(); j++) {
+                if (std::abs(glm::dot(axis, game->cubes[j].position()) - depth) < 0.25f)
+                    indices.push_back(j);
             }
+
+            // Keep the logical model in sync
+            int quarter_turns = angle > 135.f ? 2 : (forward ? 3 : 1);
+            game->facelets.turn(rotated_color.face(), layer, quarter_turns);
+            if (record) game->journal.record({rotated_color.face(), uint8_t(layer), uint8_t(quarter_turns)});
+
+            // Set the motion
+            rotation_axis = axis;
+            layer_depth = depth;
+            rotation_sign = forward ? 1.0f : -1.0f;
+            current_transform = glm::toMat4(angleAxis(rotation_sign * angular_step, axis));
         }
 
-        // Set the motion
-        current_transform = glm::toMat4(angleAxis(forward ? angular_step : -angular_step, center_pos));
-    }
+        /// Applies at once the rest of the current move, and ends it
+        void complete_move() {
+            mat4 rest = glm::toMat4(angleAxis(remaining_angle * rotation_sign, rotation_axis));
+            for (const auto& i: indices)
+                game->cubes[i].apply(rest);
+            end_move();
+        }
+
+        /// Removes the rounding errors of the cubes moved
+        void end_move() {
+            is_running = false;
+            for (const auto& i: indices)
+                game->cubes[i].snap();
+        }
+
+        /// Keeps a copy of the cube in the journal if it is time
+        void keep_checkpoint() {
+            if (game->journal.is_checkpoint_due())
+                game->journal.add_checkpoint(game->cubes, game->facelets.facelets);
+        }
 
-    private:
         /// Current game
         RubicsCube* game;
 
@@ -424,4 +673,15 @@ public:
 
         /// Current motion being applied
         mat4 current_transform;
-};
\ No newline at end of file
+
+        /// Axis of the current motion, and its direction (1 for counter-clockwise)
+        vec3 rotation_axis;
+        /// Depth of the layer turned, along the axis
+        float layer_depth = 0.0f;
+        float rotation_sign = 1.0f;
+
+        /// Moves waiting for the current one to end
+        std::deque<LayerMove> queue;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scrambler.cpp"
+#include "state_io.cpp"
+
+using std::cout;
+using std::endl;
+
+/**
+ * Prints random-state scrambles, and measures how fast random states are made.
+ *
+ * Usage: Scramble [states] [threads] [file]
+ *
+ * With a file, writes the random states there instead (see `state_io.cpp`).
+ */
+int main(int argc, char** argv)
+{
+    uint64_t states = argc > 1 ? std::stoull(argv[1]) : 100000000;
+    unsigned threads = argc > 2 ? std::stoi(argv[2]) : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    Scrambler scrambler(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    if (argc > 3) {
+        StateFileWriter writer;
+        if (!writer.open(argv[3])) {
+            cout << "Cannot write " << argv[3] << endl;
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < states; i++) writer.add(scrambler.random_state());
+        if (!writer.close()) {
+            cout << "Cannot write " << argv[3] << endl;
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        cout << states << " states written to " << argv[3] << " (" << states / seconds << " / s)" << endl;
+        return 0;
+    }
+
+    TwoPhaseSolver solver;
+    for (int i = 0; i < 5; i++) cout << format_moves(scrambler.scramble(solver)) << endl;
+
+    // Raw states: each thread has its own generator, on its own part of the sequence
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> checksum(0);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+            Scrambler local(42);
+            for (unsigned j = 0; j <= t; j++) local.jump();
+            uint64_t sum = 0;
+            for (uint64_t i = t; i < states; i += threads) {
+                CubeState s = local.random_state();
+                sum += s.cp[0] + s.ep[0] + s.co[7] + s.eo[11];
+            }
+            checksum += sum;
+        });
+    }
+    for (auto& t: pool) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cout << "random states: " << states / seconds << " / s (" << threads << " threads, checksum " << checksum << ")" << endl;
+
+    // Scrambles: a random state and its two-phase solution
+    const int scrambles = 200;
+    size_t moves = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < scrambles; i++) moves += scrambler.scramble(solver).size();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cout << "scrambles: " << scrambles / seconds << " / s (1 thread), " << double(moves) / scrambles << " moves" << endl;
+    return 0;
+}
@@ -0,0 +1,117 @@
+#ifndef SCRAMBLER_H
+#define SCRAMBLER_H
+
+#include <utility>
+#include <vector>
+
+#include "cubestate.cpp"
+#include "faceletcube.cpp"
+#include "pocket_solver.cpp"
+#include "twophase.cpp"
+#include "xoshiro.cpp"
+
+/**
+ * Random scrambles, with every state equally likely.
+ *
+ * Random moves do not give uniform states (20 random moves are still biased towards the
+ * states close to the start). Instead, a random state is built directly: random permutations
+ * of the corners and of the edges (Fisher-Yates), with two edges swapped when their parities
+ * differ, and random orientations, the last piece of each kind taking the orientation that
+ * makes the sum valid. The moves of the scramble are then given by a solver.
+ */
+class Scrambler {
+public:
+    Scrambler(uint64_t seed = 0x5eed) : random(seed) { }
+
+    /// Gives the scrambler a sequence of random numbers that no other scrambler with the same seed uses
+    void jump() { random.jump(); }
+
+    /// @return Returns a random state of the 3x3x3 (43252003274489856000 possible ones)
+    CubeState random_state() {
+        CubeState s;
+        int corner_parity = shuffle(s.cp.data(), CubeState::CORNERS);
+        int edge_parity = shuffle(s.ep.data(), CubeState::EDGES);
+        if (corner_parity != edge_parity) std::swap(s.ep[CubeState::EDGES - 2], s.ep[CubeState::EDGES - 1]);
+        orient(s.co.data(), CubeState::CORNERS, 3);
+        orient(s.eo.data(), CubeState::EDGES, 2);
+        return s;
+    }
+
+    /// @return Returns a random state of the 2x2x2 corners, with the DBL corner solved
+    CubeState random_pocket_state() {
+        CubeState s;
+        uint8_t p[7] = {0, 1, 2, 3, 4, 5, 7};
+        shuffle(p, 7);
+        for (int i = 0, k = 0; i < CubeState::CORNERS; i++)
+            if (i != 6) s.cp[i] = p[k++];
+        uint8_t o[7];
+        orient(o, 7, 3);
+        for (int i = 0, k = 0; i < CubeState::CORNERS; i++)
+            if (i != 6) s.co[i] = o[k++];
+        return s;
+    }
+
+    /// @return Returns moves leading to a random state of the 3x3x3 (the inverse of its solution)
+    std::vector<Move> scramble(const TwoPhaseSolver& solver) {
+        std::vector<Move> solution;
+        solver.solve(random_state(), solution);
+        return invert_moves(solution);
+    }
+
+    /// @return Returns the shortest moves leading to a random state of the 2x2x2
+    std::vector<Move> scramble(const PocketCubeSolver& solver) {
+        std::vector<Move> solution;
+        solver.solve(random_pocket_state(), solution);
+        return invert_moves(solution);
+    }
+
+    /**
+     * @return Returns random layer turns, for the bigger cubes (no two turns in a row around
+     * the same axis, so that none of them is wasted)
+     */
+    std::vector<LayerMove> random_moves(int size, int count) {
+        std::vector<LayerMove> moves;
+        int last_axis = -1;
+        while (int(moves.size()) < count) {
+            int axis = random.below(3);
+            if (axis == last_axis) continue;
+            last_axis = axis;
+            moves.push_back({Face(axis), uint8_t(random.below(size)), uint8_t(1 + random.below(3))});
+        }
+        return moves;
+    }
+
+private:
+    Xoshiro256 random;
+
+    /// Shuffles values in place (Fisher-Yates). @return Returns the parity of the permutation applied
+    int shuffle(uint8_t* values, int n) {
+        int parity = 0;
+        for (int i = n - 1; i > 0; i--) {
+            int j = random.below(i + 1);
+            if (j != i) {
+                std::swap(values[i], values[j]);
+                parity ^= 1;
+            }
+        }
+        return parity;
+    }
+
+    /// Random orientations in [0, modulo), the last one making the sum a multiple of `modulo`
+    void orient(uint8_t* o, int n, int modulo) {
+        int sum = 0;
+        for (int i = 0; i < n - 1; i++) {
+            o[i] = random.below(modulo);
+            sum += o[i];
+        }
+        o[n - 1] = (modulo - sum % modulo) % modulo;
+    }
+
+    static std::vector<Move> invert_moves(const std::vector<Move>& moves) {
+        std::vector<Move> inverse;
+        for (auto it = moves.rbegin(); it != moves.rend(); ++it) inverse.push_back(move_inverse(*it));
+        return inverse;
+    }
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glm/glm.hpp>
+
+#include "rubicscube.cpp"
+
+static_assert(std::is_trivially_copyable<Cube>::value, "the cubes are saved as raw bytes");
+static_assert(sizeof(LayerMove) == 3, "the history is saved as raw bytes");
+
+/// First bytes of a session file, followed by the cubes, the stickers and the history
+struct SessionHeader {
+    char magic[8];
+    uint32_t version;
+    /// Size of a `Cube` in the program that wrote the file: the cubes are its raw memory
+    uint32_t cube_bytes;
+    uint32_t size;
+    uint32_t cubes;
+    uint64_t history;
+    float camera_pos[3];
+    float camera_up[3];
+    int32_t current_layer;
+    uint8_t current_face;
+    uint8_t reserved[3];
+};
+
+/**
+ * Saves what the player sees when leaving (the cube, the camera, the selected face and the
+ * moves played), and gives it back at the next start.
+ *
+ * The file is the memory of the cubes as it is: loading it maps the file and copies the
+ * cubes, with no move replayed and no cube placed again. It is only read back by the same
+ * build (the size of a `Cube` is checked), any other file starts a new cube. Every cube,
+ * sticker and move of the file is checked before it is used: a damaged file starts a new
+ * cube too.
+ */
+class Session {
+public:
+    static constexpr const char* DEFAULT_PATH = "rubicscube.session";
+
+    /**
+     * Writes the session to a temporary file, then renames it, so that a crash while
+     * writing leaves the previous session intact.
+     * @return Returns false if the file cannot be written
+     */
+    static bool save(const std::string& path, const RubicsCube& game, glm::vec3 camera_pos, glm::vec3 camera_up) {
+        SessionHeader h = {};
+        std::memcpy(h.magic, MAGIC, sizeof(h.magic));
+        h.version = VERSION;
+        h.cube_bytes = sizeof(Cube);
+        h.size = game.size;
+        h.cubes = game.cubes.size();
+        h.history = game.journal.position();
+        for (int i = 0; i < 3; i++) {
+            h.camera_pos[i] = camera_pos[i];
+            h.camera_up[i] = camera_up[i];
+        }
+        h.current_layer = game.current_layer;
+        h.current_face = game.current_face;
+
+        std::string temporary = path + ".tmp";
+        int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        bool ok = write_all(fd, &h, sizeof(h))
+            && write_all(fd, game.cubes.data(), game.cubes.size() * sizeof(Cube))
+            && write_all(fd, game.facelets.facelets.data(), game.facelets.facelets.size())
+            && write_all(fd, game.journal.moves().data(), game.journal.position() * sizeof(LayerMove));
+        ok = ::close(fd) == 0 && ok;
+        return ok && std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    /**
+     * Restores a saved session.
+     * @return Returns false, and changes nothing, if there is no valid session in the file
+     */
+    static bool load(const std::string& path, RubicsCube& game, glm::vec3& camera_pos, glm::vec3& camera_up) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(SessionHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        const uint8_t* mapping = static_cast<const uint8_t*>(p);
+
+        const SessionHeader* h = reinterpret_cast<const SessionHeader*>(mapping);
+        uint64_t facelets = 6ull * h->size * h->size;
+        bool ok = std::memcmp(h->magic, MAGIC, sizeof(h->magic)) == 0 && h->version == VERSION
+            && h->cube_bytes == sizeof(Cube) && h->size >= 2 && h->size <= 64
+            && h->cubes == expected_cubes(h->size) && h->current_face < Color::NONE
+            && h->current_layer >= 0 && h->current_layer < int32_t(h->size)
+            && uint64_t(st.st_size) == sizeof(SessionHeader) + h->cubes * sizeof(Cube) + facelets
+                                       + h->history * sizeof(LayerMove);
+        const Cube* cubes = reinterpret_cast<const Cube*>(mapping + sizeof(SessionHeader));
+        const uint8_t* stickers = mapping + sizeof(SessionHeader) + h->cubes * sizeof(Cube);
+        const LayerMove* history = reinterpret_cast<const LayerMove*>(stickers + facelets);
+        for (int i = 0; ok && i < 3; i++)
+            ok = std::isfinite(h->camera_pos[i]) && std::isfinite(h->camera_up[i]);
+        for (uint64_t i = 0; ok && i < h->cubes; i++) ok = is_valid(cubes[i], h->size);
+        for (uint64_t i = 0; ok && i < facelets; i++) ok = stickers[i] < 6;
+        for (uint64_t i = 0; ok && i < h->history; i++) ok = is_valid(history[i], h->size);
+        if (ok) {
+            game = RubicsCube(h->size, std::vector<Cube>(cubes, cubes + h->cubes), stickers,
+                              std::vector<LayerMove>(history, history + h->history));
+            game.current_face = Color::Value(h->current_face);
+            game.current_layer = h->current_layer;
+            camera_pos = glm::vec3(h->camera_pos[0], h->camera_pos[1], h->camera_pos[2]);
+            camera_up = glm::vec3(h->camera_up[0], h->camera_up[1], h->camera_up[2]);
+        }
+        munmap(p, st.st_size);
+        return ok;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'R', 'C', 'S', 'E', 'S', 'S', 0, 0};
+    static constexpr uint32_t VERSION = 1;
+
+    /// Number of cubes on the surface of a NxNxN cube
+    static uint64_t expected_cubes(uint64_t n) { return 6 * n * n - 12 * n + 8; }
+
+    /// @return Returns false if the cube is not within the rubicscube (even turning), or has no valid colors
+    static bool is_valid(const Cube& c, uint32_t size) {
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                if (!std::isfinite(c.transform[i][j])) return false;
+        // Turns keep the distance to the center: at most that of the corners
+        float radius = (size - 1) / 2.0f * std::sqrt(3.0f);
+        return glm::length(c.position()) <= radius + 0.01f && Color::Value(c.color1) <= Color::NONE
+            && Color::Value(c.color2) <= Color::NONE && Color::Value(c.color3) <= Color::NONE;
+    }
+
+    /// @return Returns false if the move is not a turn of a layer of a cube of this size
+    static bool is_valid(const LayerMove& m, uint32_t size) {
+        return m.face <= FACE_B && m.layer < size && m.power >= 1 && m.power <= 3;
+    }
+
+    static bool write_all(int fd, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = ::write(fd, p, size);
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+};
+
+#endif
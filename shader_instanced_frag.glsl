@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+// Layer of the color of the face, and whether the cube is on the main face
+flat in ivec2 Sticker;
+
+// One layer per color, the last one is the "selected" texture
+uniform sampler2DArray colors;
+// Color of the "selected" texture
+uniform vec4 highlightColor;
+
+void main()
+{
+	FragColor = texture(colors, vec3(TexCoord, Sticker.x));
+
+	// If main face, lighter
+	FragColor = mix(FragColor, highlightColor, 0.5 * float(Sticker.y));
+}
@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aTexCoord;
+// Per-instance attributes
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in ivec4 aColors;
+
+out vec2 TexCoord;
+// Layer of the color of the face, and whether the cube is on the main face
+flat out ivec2 Sticker;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+	// The color of each face (the top color is also drawn on the bottom)
+	int palette[6] = int[6](6, aColors.x, 6, aColors.y, aColors.z, aColors.z);
+	TexCoord = aTexCoord.xy;
+	Sticker = ivec2(palette[int(aTexCoord.z)], aColors.w);
+	gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+}
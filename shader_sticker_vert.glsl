@@ -0,0 +1,39 @@
+#version 330 core
+// The corners of the faces of a cube, 4 per face (in the order of `Scene`: back, front, left,
+// right, bottom, top), counter-clockwise seen from outside
+const vec3 corners[24] = vec3[24](
+	vec3(-0.5, -0.5, -0.5), vec3(-0.5, 0.5, -0.5), vec3(0.5, 0.5, -0.5), vec3(0.5, -0.5, -0.5),
+	vec3(-0.5, -0.5, 0.5), vec3(0.5, -0.5, 0.5), vec3(0.5, 0.5, 0.5), vec3(-0.5, 0.5, 0.5),
+	vec3(-0.5, 0.5, 0.5), vec3(-0.5, 0.5, -0.5), vec3(-0.5, -0.5, -0.5), vec3(-0.5, -0.5, 0.5),
+	vec3(0.5, 0.5, 0.5), vec3(0.5, -0.5, 0.5), vec3(0.5, -0.5, -0.5), vec3(0.5, 0.5, -0.5),
+	vec3(-0.5, -0.5, -0.5), vec3(0.5, -0.5, -0.5), vec3(0.5, -0.5, 0.5), vec3(-0.5, -0.5, 0.5),
+	vec3(-0.5, 0.5, -0.5), vec3(-0.5, 0.5, 0.5), vec3(0.5, 0.5, 0.5), vec3(0.5, 0.5, -0.5)
+);
+const vec2 texCoords[24] = vec2[24](
+	vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(1.0, 0.0),
+	vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0),
+	vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0),
+	vec2(1.0, 0.0), vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0),
+	vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(1.0, 0.0), vec2(0.0, 0.0),
+	vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0)
+);
+
+// Per-instance attributes: the transform of the cube, and its sticker (face, layer of the
+// color, and whether the cube is on the main face)
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in ivec4 aSticker;
+
+out vec2 TexCoord;
+flat out ivec2 Sticker;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+	// A sticker is a fan of 4 vertices
+	int corner = aSticker.x * 4 + gl_VertexID;
+	TexCoord = texCoords[corner];
+	Sticker = aSticker.yz;
+	gl_Position = projection * view * aModel * vec4(corners[corner], 1.0);
+}
@@ -0,0 +1,53 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "solver.cpp"
+
+using std::cout;
+using std::endl;
+
+/**
+ * Solves a scramble optimally.
+ *
+ * Usage: Solve "<scramble>" [pattern databases directory] [--table <megabytes>]
+ *
+ * `--table` adds a transposition table of that size (none by default).
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        cout << "Usage: Solve \"<scramble>\" [pattern databases directory] [--table <megabytes>]" << endl;
+        return 1;
+    }
+    std::string directory = ".";
+    size_t table_megabytes = 0;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--table" && i + 1 < argc)
+            table_megabytes = std::strtoul(argv[++i], nullptr, 10);
+        else
+            directory = arg;
+    }
+
+    OptimalSolver solver(std::thread::hardware_concurrency(), table_megabytes);
+    if (!solver.load(directory))
+        cout << "Some pattern databases are missing in " << directory << " (run PdbGen)" << endl;
+
+    CubeState state;
+    state.apply(parse_moves(argv[1]));
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Move> solution;
+    bool ok = solver.solve(state, solution);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!ok) {
+        cout << "No solution found" << endl;
+        return 1;
+    }
+    cout << format_moves(solution) << " (" << solution.size() << " moves)" << endl;
+    cout << solver.nodes << " nodes expanded in " << seconds << " s" << endl;
+    return 0;
+}
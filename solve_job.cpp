@@ -0,0 +1,137 @@
+#ifndef SOLVE_JOB_H
+#define SOLVE_JOB_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "faceletcube.cpp"
+#include "solver.cpp"
+
+/**
+ * A solve running in the background: the game keeps it, and looks at it without ever
+ * waiting for it.
+ *
+ * The solver publishes its best solution so far with `offer` (a quick one first, then
+ * shorter ones, if it looks for them), and its progress in `progress`. The game plays each
+ * solution as soon as it sees it. Cancelling the job stops the search; the best solution
+ * found until then stays.
+ */
+class SolveJob {
+public:
+    SearchProgress progress;
+
+    /// Replaces the best solution so far (solver only)
+    void offer(const std::vector<LayerMove>& solution) {
+        std::lock_guard<std::mutex> lock(mutex);
+        best = solution;
+        offers++;
+    }
+
+    /**
+     * Copies the best solution so far.
+     * @return Returns the number of solutions offered until now (a new one each time it
+     *         grows), 0 if none was found yet
+     */
+    unsigned best_solution(std::vector<LayerMove>& solution) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (offers) solution = best;
+        return offers;
+    }
+
+    /// @return Returns true once the solve is over: all its solutions are offered
+    bool is_done() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return done;
+    }
+
+    void cancel() { progress.cancel = true; }
+
+    /// Marks the end of the solve (pool only)
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::vector<LayerMove> best;
+    unsigned offers = 0;
+    bool done = false;
+};
+
+/**
+ * Threads that run solves, one at a time each, in the order they are submitted.
+ */
+class SolverPool {
+public:
+    /// The solve itself, run on a thread of the pool
+    using Task = std::function<void(SolveJob&)>;
+
+    SolverPool(unsigned workers = 1) {
+        for (unsigned i = 0; i < std::max(workers, 1u); i++)
+            threads.emplace_back([this] { work(); });
+    }
+
+    SolverPool(const SolverPool&) = delete;
+    SolverPool& operator=(const SolverPool&) = delete;
+
+    /// Cancels the solves still running or waiting, and waits for the threads
+    ~SolverPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            for (auto& job: running) job->cancel();
+            for (auto& pending: queue) pending.first->cancel();
+        }
+        changed.notify_all();
+        for (auto& t: threads) t.join();
+    }
+
+    /// @return Returns the job, which the caller polls
+    std::shared_ptr<SolveJob> submit(Task task) {
+        auto job = std::make_shared<SolveJob>();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.emplace_back(job, std::move(task));
+        }
+        changed.notify_one();
+        return job;
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<std::shared_ptr<SolveJob>, Task>> queue;
+    std::vector<std::shared_ptr<SolveJob>> running;
+    bool stopping = false;
+
+    void work() {
+        for (;;) {
+            std::pair<std::shared_ptr<SolveJob>, Task> next;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                next = std::move(queue.front());
+                queue.pop_front();
+                running.push_back(next.first);
+            }
+            if (!next.first->progress.cancel) next.second(*next.first);
+            next.first->finish();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running.erase(std::find(running.begin(), running.end(), next.first));
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cubestate.cpp"
+#include "pattern_database.cpp"
+#include "transposition_table.cpp"
+
+/**
+ * Progress of a search, read while it runs (from any thread), and a way to stop it.
+ */
+struct SearchProgress {
+    /// Nodes expanded so far (counted by blocks of `NODES_BLOCK`)
+    std::atomic<uint64_t> nodes{0};
+    /// Depth being searched
+    std::atomic<int> depth{0};
+    /// Set to stop the search as soon as possible
+    std::atomic<bool> cancel{false};
+
+    static constexpr uint64_t NODES_BLOCK = 4096;
+};
+
+/**
+ * Optimal solver: IDA* with the maximum of three pattern databases as heuristic
+ * (the corners, and two groups of 6 edges).
+ *
+ * Only canonical sequences are searched (see `canonical_successors`).
+ *
+ * The iterations are split between threads at depth 2: each thread takes the next
+ * 2-moves prefix and searches all the sequences that start with it.
+ *
+ * A transposition table, shared by all threads, can remember the bounds learned by the
+ * search. It is off by default: with the pattern databases, it cuts less than 1% of the nodes
+ * of a 3x3x3 scramble, for more time than it saves. Its bounds hold for any scramble (they
+ * are distances to solved), so it is kept from one solve to the next.
+ */
+class OptimalSolver {
+public:
+    /// Number of nodes expanded by the last call to `solve`
+    uint64_t nodes = 0;
+
+    /// If set, the search reports its progress there, and stops when it is cancelled
+    SearchProgress* progress = nullptr;
+
+    /// @param table_megabytes Memory of the transposition table (0 for none)
+    OptimalSolver(unsigned _threads = std::thread::hardware_concurrency(), size_t table_megabytes = 0)
+        : first_pattern(0), last_pattern(6), threads(_threads ? _threads : 1) {
+        if (table_megabytes) table.reset(new TranspositionTable(table_megabytes));
+    }
+
+    /**
+     * Maps the tables generated by `PdbGen` in memory.
+     * @return Returns false if a table is missing, in which case the search is much slower.
+     */
+    bool load(const std::string& directory) {
+        bool ok = corners.load(directory + "/" + pattern_file_name(PATTERN_CORNERS), PATTERN_CORNERS, corner_pattern.size());
+        ok &= edges_first.load(directory + "/" + pattern_file_name(PATTERN_EDGES_FIRST), PATTERN_EDGES_FIRST, first_pattern.size());
+        ok &= edges_last.load(directory + "/" + pattern_file_name(PATTERN_EDGES_LAST), PATTERN_EDGES_LAST, last_pattern.size());
+        return ok;
+    }
+
+    /// @return Returns a lower bound of the number of moves needed to solve a state
+    int heuristic(const CubeState& s) const {
+        int h = 0;
+        if (corners.is_loaded()) h = std::max<int>(h, corners[corner_pattern.index(s)]);
+        if (edges_first.is_loaded()) h = std::max<int>(h, edges_first[first_pattern.index(s)]);
+        if (edges_last.is_loaded()) h = std::max<int>(h, edges_last[last_pattern.index(s)]);
+        return h;
+    }
+
+    /**
+     * Finds a shortest solution of the given state.
+     * @return Returns false if there is no solution of at most `max_depth` moves, or if the
+     *         search was cancelled (see `progress`)
+     */
+    bool solve(const CubeState& start, std::vector<Move>& solution, int max_depth = 20) {
+        nodes = 0;
+        solution.clear();
+        if (start.is_solved()) return true;
+
+        int bound = heuristic(start);
+        while (bound <= max_depth) {
+            if (progress) progress->depth = bound;
+            int next = iterate(start, bound, solution);
+            if (next == FOUND) return true;
+            if (next == INT_MAX) return false;
+            bound = next;
+        }
+        return false;
+    }
+
+private:
+    static constexpr int FOUND = -1;
+
+    CornerPattern corner_pattern;
+    PatternDatabase corners, edges_first, edges_last;
+    std::unique_ptr<TranspositionTable> table;
+    EdgePattern first_pattern, last_pattern;
+    unsigned threads;
+
+    /**
+     * Key of the table. The bound learned below a state depends on the moves allowed from it,
+     * which depend on the face of the previous move.
+     */
+    static uint64_t key(const CubeState& s, int last_face) {
+        return s.hash() ^ (uint64_t(last_face + 1) * 0x9e3779b97f4a7c15ull);
+    }
+
+    /**
+     * Depth first search below `s`, reached with `g` moves.
+     * @return Returns FOUND, or the smallest cost above `bound` met in the subtree
+     */
+    int search(const CubeState& s, int g, int bound, int last_face, std::vector<Move>& path,
+               uint64_t& expanded, const std::atomic<bool>& stop) {
+        int h = heuristic(s);
+        if (table && h + g <= bound)
+            h = std::max(h, table->lookup(key(s, last_face)));
+        if (g + h > bound) return g + h;
+        if (h == 0 && s.is_solved()) return FOUND;
+        if (stop.load(std::memory_order_relaxed)) return INT_MAX;
+        if (progress && progress->cancel.load(std::memory_order_relaxed)) return INT_MAX;
+
+        if (++expanded % SearchProgress::NODES_BLOCK == 0 && progress)
+            progress->nodes.fetch_add(SearchProgress::NODES_BLOCK, std::memory_order_relaxed);
+        int best = INT_MAX;
+        for (Move m: canonical_successors(last_face)) {
+            int face = move_face(m);
+            path.push_back(m);
+            int r = search(s * CubeState::moves()[m], g + 1, bound, face, path, expanded, stop);
+            if (r == FOUND) return FOUND;
+            path.pop_back();
+            best = std::min(best, r);
+        }
+        // A search stopped in the middle only saw some of the successors: its bound is wrong
+        if (stop.load(std::memory_order_relaxed)) return INT_MAX;
+        if (progress && progress->cancel.load(std::memory_order_relaxed)) return INT_MAX;
+        if (table && best != INT_MAX)
+            table->store(key(s, last_face), best - g);
+        return best;
+    }
+
+    /**
+     * One iteration of IDA*, on all threads.
+     */
+    int iterate(const CubeState& start, int bound, std::vector<Move>& solution) {
+        // The prefixes given to the threads
+        std::vector<std::vector<Move>> prefixes;
+        for (Move a: canonical_successors(NO_FACE)) {
+            if (bound < 2) {
+                prefixes.push_back({a});
+                continue;
+            }
+            for (Move b: canonical_successors(move_face(a)))
+                prefixes.push_back({a, b});
+        }
+
+        std::atomic<size_t> next_prefix(0);
+        std::atomic<bool> found(false);
+        std::vector<int> best(threads, INT_MAX);
+        std::vector<uint64_t> expanded(threads, 0);
+
+        auto worker = [&](unsigned id) {
+            std::vector<Move> path;
+            for (;;) {
+                size_t i = next_prefix.fetch_add(1);
+                if (i >= prefixes.size() || found.load()) return;
+                CubeState s = start;
+                s.apply(prefixes[i]);
+                path = prefixes[i];
+                int r = search(s, path.size(), bound, move_face(path.back()), path, expanded[id], found);
+                if (r == FOUND) {
+                    // Only the first thread to find a solution writes it
+                    if (!found.exchange(true)) solution = path;
+                    return;
+                }
+                best[id] = std::min(best[id], r);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker, t);
+        worker(0);
+        for (auto& t: pool) t.join();
+
+        for (uint64_t e: expanded) nodes += e;
+        if (found) return FOUND;
+        if (progress && progress->cancel) return INT_MAX;
+        return *std::min_element(best.begin(), best.end());
+    }
+};
+
+#endif
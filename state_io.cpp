@@ -0,0 +1,276 @@
+#ifndef STATE_IO_H
+#define STATE_IO_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cubestate.cpp"
+#include "pattern_database.cpp"
+
+/**
+ * A 3x3x3 state in 9 bytes, as two coordinates:
+ *  - corners: rank of the permutation (8!) times the twists of the first 7 corners (3^7), 27 bits
+ *  - edges: rank of the permutation (12!) times the flips of the first 11 edges (2^11), 40 bits
+ *
+ * The 67 bits are stored little endian, corners first. The orientations of the last corner
+ * and of the last edge are implied by the others.
+ */
+struct PackedState {
+    static constexpr uint64_t TWISTS = 2187;
+    static constexpr uint64_t FLIPS = 2048;
+    static constexpr uint64_t CORNER_VALUES = 40320 * TWISTS;
+    static constexpr uint64_t EDGE_VALUES = 479001600 * FLIPS;
+    static constexpr int CORNER_BITS = 27;
+
+    uint8_t bytes[9];
+
+    static PackedState encode(const CubeState& s) {
+        uint64_t corners = rank_permutation(s.cp.data(), CubeState::CORNERS);
+        for (int i = 0; i < CubeState::CORNERS - 1; i++) corners = corners * 3 + s.co[i];
+        uint64_t edges = rank_permutation(s.ep.data(), CubeState::EDGES);
+        for (int i = 0; i < CubeState::EDGES - 1; i++) edges = edges * 2 + s.eo[i];
+
+        uint64_t low = corners | (edges << CORNER_BITS);
+        PackedState p;
+        for (int i = 0; i < 8; i++) p.bytes[i] = low >> (8 * i);
+        p.bytes[8] = edges >> (64 - CORNER_BITS);
+        return p;
+    }
+
+    /**
+     * @return Returns false if the bytes are not the encoding of a state that can be solved
+     */
+    bool decode(CubeState& s) const {
+        uint64_t low = 0;
+        for (int i = 0; i < 8; i++) low |= uint64_t(bytes[i]) << (8 * i);
+        uint64_t corners = low & ((uint64_t(1) << CORNER_BITS) - 1);
+        uint64_t edges = (low >> CORNER_BITS) | (uint64_t(bytes[8]) << (64 - CORNER_BITS));
+        if (corners >= CORNER_VALUES || edges >= EDGE_VALUES) return false;
+
+        int twist = 0;
+        for (int i = CubeState::CORNERS - 2; i >= 0; i--) {
+            s.co[i] = corners % 3;
+            twist += s.co[i];
+            corners /= 3;
+        }
+        s.co[CubeState::CORNERS - 1] = (3 - twist % 3) % 3;
+        int parity = rank_parity(corners, CubeState::CORNERS);
+        unrank_permutation(corners, s.cp.data(), CubeState::CORNERS);
+
+        int flip = 0;
+        for (int i = CubeState::EDGES - 2; i >= 0; i--) {
+            s.eo[i] = edges & 1;
+            flip += s.eo[i];
+            edges >>= 1;
+        }
+        s.eo[CubeState::EDGES - 1] = flip & 1;
+        parity ^= rank_parity(edges, CubeState::EDGES);
+        unrank_permutation(edges, s.ep.data(), CubeState::EDGES);
+        return parity == 0;
+    }
+
+private:
+    /// Parity of the permutation of a rank: the sum of the digits of its Lehmer code
+    static int rank_parity(uint32_t r, int n) {
+        int sum = 0;
+        for (int i = n - 1; i >= 0; i--) {
+            sum += r % (n - i);
+            r /= (n - i);
+        }
+        return sum & 1;
+    }
+};
+static_assert(sizeof(PackedState) == 9, "PackedState must have no padding");
+
+/// Letter of each face, in the order of `Face`
+inline constexpr char FACE_LETTERS[] = "URFDLB";
+
+/**
+ * Writes a state as 54 letters, one per sticker: the face of its color (U, R, F, D, L or B),
+ * in the order of `CubeState::to_facelets`. The solved cube is "UUUUUUUUURRRRRRRRRFFF...".
+ */
+inline void write_facelet_string(const CubeState& s, char* text) {
+    uint8_t f[54];
+    s.to_facelets(f);
+    for (int i = 0; i < 54; i++) text[i] = FACE_LETTERS[f[i]];
+}
+
+/**
+ * Reads the 54 letters of `write_facelet_string`.
+ * @return Returns false if they do not describe a cube that can be solved
+ */
+inline bool read_facelet_string(const char* text, CubeState& s) {
+    uint8_t f[54];
+    for (int i = 0; i < 54; i++) {
+        const char* letter = static_cast<const char*>(std::memchr(FACE_LETTERS, text[i], 6));
+        if (!letter) return false;
+        f[i] = letter - FACE_LETTERS;
+    }
+    return CubeState::from_facelets(f, s);
+}
+
+inline std::string facelet_string(const CubeState& s) {
+    std::string text(54, ' ');
+    write_facelet_string(s, &text[0]);
+    return text;
+}
+
+inline bool parse_facelet_string(const std::string& text, CubeState& s) {
+    return text.size() == 54 && read_facelet_string(text.data(), s);
+}
+
+/// First bytes of a file of states
+struct StateFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t states;
+};
+
+/**
+ * Writes a file of states: a header, then one `PackedState` per state. The states go
+ * through a fixed buffer, written when full, so there is no allocation per state.
+ */
+class StateFileWriter {
+public:
+    static constexpr size_t BUFFER_STATES = 1 << 16;
+
+    StateFileWriter() : buffer(BUFFER_STATES) { }
+    StateFileWriter(const StateFileWriter&) = delete;
+    StateFileWriter& operator=(const StateFileWriter&) = delete;
+    ~StateFileWriter() { close(); }
+
+    /// @return Returns false if the file cannot be created
+    bool open(const std::string& path) {
+        close();
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        count = 0;
+        buffered = 0;
+        ok = fd >= 0;
+        StateFileHeader h = {};
+        write(&h, sizeof(h));
+        return ok;
+    }
+
+    void add(const CubeState& s) {
+        buffer[buffered++] = PackedState::encode(s);
+        count++;
+        if (buffered == BUFFER_STATES) flush();
+    }
+
+    /**
+     * Writes the buffered states and the header, and closes the file.
+     * @return Returns false if anything could not be written
+     */
+    bool close() {
+        if (fd < 0) return false;
+        flush();
+        StateFileHeader h;
+        std::memcpy(h.magic, STATE_FILE_MAGIC, sizeof(h.magic));
+        h.version = STATE_FILE_VERSION;
+        h.record_size = sizeof(PackedState);
+        h.states = count;
+        if (pwrite(fd, &h, sizeof(h), 0) != ssize_t(sizeof(h))) ok = false;
+        if (::close(fd) != 0) ok = false;
+        fd = -1;
+        return ok;
+    }
+
+    uint64_t states() const { return count; }
+
+    static constexpr char STATE_FILE_MAGIC[8] = {'R', 'C', 'S', 'T', 'A', 'T', 'E', 0};
+    static constexpr uint32_t STATE_FILE_VERSION = 1;
+
+private:
+    int fd = -1;
+    bool ok = false;
+    uint64_t count = 0;
+    std::vector<PackedState> buffer;
+    size_t buffered = 0;
+
+    void flush() {
+        write(buffer.data(), buffered * sizeof(PackedState));
+        buffered = 0;
+    }
+
+    void write(const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (ok && size > 0) {
+            ssize_t n = ::write(fd, p, size);
+            if (n <= 0) ok = false;
+            else {
+                p += n;
+                size -= n;
+            }
+        }
+    }
+};
+
+/**
+ * Reads a file of states written by `StateFileWriter`. The file is mapped in memory, and a
+ * state is decoded from its 9 bytes when it is asked for.
+ */
+class StateFileReader {
+public:
+    StateFileReader() = default;
+    StateFileReader(const StateFileReader&) = delete;
+    StateFileReader& operator=(const StateFileReader&) = delete;
+    ~StateFileReader() { close(); }
+
+    /// @return Returns false if the file is missing or is not a file of states
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(StateFileHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        mapping = static_cast<const uint8_t*>(p);
+        mapping_size = st.st_size;
+
+        const StateFileHeader* h = reinterpret_cast<const StateFileHeader*>(mapping);
+        if (std::memcmp(h->magic, StateFileWriter::STATE_FILE_MAGIC, sizeof(h->magic)) != 0
+            || h->version != StateFileWriter::STATE_FILE_VERSION || h->record_size != sizeof(PackedState)
+            || (mapping_size - sizeof(StateFileHeader)) / sizeof(PackedState) < h->states) {
+            close();
+            return false;
+        }
+        madvise(p, mapping_size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if (mapping) munmap(const_cast<uint8_t*>(mapping), mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+
+    uint64_t states() const {
+        return mapping ? reinterpret_cast<const StateFileHeader*>(mapping)->states : 0;
+    }
+
+    /// @return Returns false if the record of state i is not a valid state
+    bool read(uint64_t i, CubeState& s) const { return records()[i].decode(s); }
+
+    const PackedState* records() const {
+        return reinterpret_cast<const PackedState*>(mapping + sizeof(StateFileHeader));
+    }
+
+private:
+    const uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef TRAINING_DATA_H
+#define TRAINING_DATA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "cubestate.cpp"
+#include "xoshiro.cpp"
+
+/**
+ * One training sample: a state and the number of moves of the walk that reached it (an upper
+ * bound of its distance to solved). 21 bytes, with no padding, so that a file of samples is
+ * a plain array of records.
+ */
+struct TrainingRecord {
+    /// Position of each corner in the low 3 bits, its orientation above
+    uint8_t corners[CubeState::CORNERS];
+    /// Position of each edge in the low 4 bits, its orientation above
+    uint8_t edges[CubeState::EDGES];
+    uint8_t depth;
+
+    void encode(const CubeState& s, int d) {
+        for (int i = 0; i < CubeState::CORNERS; i++) corners[i] = s.cp[i] | (s.co[i] << 3);
+        for (int i = 0; i < CubeState::EDGES; i++) edges[i] = s.ep[i] | (s.eo[i] << 4);
+        depth = d;
+    }
+
+    CubeState decode() const {
+        CubeState s;
+        for (int i = 0; i < CubeState::CORNERS; i++) {
+            s.cp[i] = corners[i] & 7;
+            s.co[i] = corners[i] >> 3;
+        }
+        for (int i = 0; i < CubeState::EDGES; i++) {
+            s.ep[i] = edges[i] & 15;
+            s.eo[i] = edges[i] >> 4;
+        }
+        return s;
+    }
+};
+static_assert(sizeof(TrainingRecord) == 21, "TrainingRecord must have no padding");
+
+/**
+ * Writes (state, depth) samples for learned heuristics, as in DeepCubeA: random walks from
+ * solved, each state of a walk being a sample whose depth is its number of moves.
+ *
+ * The walks never turn the same face twice in a row, nor two opposite faces in both orders
+ * (see `canonical_successors`), so that no move undoes the previous one.
+ *
+ * Each thread fills its own buffer of records, then reserves a range of the file with an
+ * atomic counter and writes the whole buffer there with `pwrite`: there is no lock, and no
+ * allocation per sample.
+ *
+ * A buffer holds whole walks, and its random numbers start `jump()` times its number after
+ * the seed: the file only depends on the seed, whatever the number of threads and whichever
+ * thread fills each buffer.
+ */
+class RandomWalkGenerator {
+public:
+    /// Records per thread buffer (about 2.6 MB), rounded down to a multiple of the walks
+    static constexpr size_t BUFFER_RECORDS = 1 << 17;
+
+    RandomWalkGenerator(int _max_depth = 30, unsigned _threads = std::thread::hardware_concurrency(), uint64_t _seed = 42)
+        : max_depth(std::max(1, std::min(_max_depth, 255))), threads(_threads ? _threads : 1), seed(_seed) { }
+
+    /**
+     * Writes `samples` records to a new file. The walks all have `max_depth` moves, but the
+     * last one if `samples` is not a multiple of it.
+     * @return Returns false if the file cannot be written
+     */
+    bool generate(const std::string& path, uint64_t samples) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+
+        const size_t buffer_records = BUFFER_RECORDS - BUFFER_RECORDS % max_depth;
+        std::atomic<uint64_t> next_sample(0);
+        std::atomic<bool> ok(true);
+        auto worker = [&]() {
+            // The generator at the start of the buffer `buffer_start`
+            Xoshiro256 start(seed);
+            uint64_t buffer_start = 0;
+            std::vector<TrainingRecord> buffer(buffer_records);
+
+            for (;;) {
+                // Reserve the next records of the file, then fill them
+                uint64_t first = next_sample.fetch_add(buffer_records);
+                if (first >= samples || !ok) return;
+                size_t count = std::min<uint64_t>(buffer_records, samples - first);
+                for (; buffer_start < first / buffer_records; buffer_start++) start.jump();
+                Xoshiro256 random = start;
+                CubeState s;
+                int depth = max_depth, last_face = NO_FACE;
+                for (size_t i = 0; i < count; i++) {
+                    if (depth == max_depth) {
+                        s = CubeState();
+                        depth = 0;
+                        last_face = NO_FACE;
+                    }
+                    const std::vector<Move>& moves = canonical_successors(last_face);
+                    Move m = moves[random.below(moves.size())];
+                    s.apply(m);
+                    last_face = move_face(m);
+                    buffer[i].encode(s, ++depth);
+                }
+                if (!write_all(fd, buffer.data(), count * sizeof(TrainingRecord), first * sizeof(TrainingRecord)))
+                    ok = false;
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+        worker();
+        for (auto& t: pool) t.join();
+        return ::close(fd) == 0 && ok;
+    }
+
+private:
+    int max_depth;
+    unsigned threads;
+    uint64_t seed;
+
+    static bool write_all(int fd, const void* data, size_t size, off_t offset) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = pwrite(fd, p, size, offset);
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+            offset += n;
+        }
+        return true;
+    }
+};
+
+#endif
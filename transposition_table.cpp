@@ -0,0 +1,94 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * A fixed size hash table remembering the best known lower bound of the distance to solved.
+ *
+ * IDA* visits the same states many times: once per iteration, and once per path leading to
+ * them. When the search below a state fails, we learn that this state needs more moves than
+ * the heuristic said. Storing this bound lets the next visit cut the branch right away.
+ *
+ * Each entry is a single 64 bits word (56 bits of tag, 8 bits of bound), so that threads can
+ * read and write entries with plain atomic operations, without any lock. The entries are
+ * grouped by 8 in buckets of one cache line: a probe costs one cache miss.
+ *
+ * When a bucket is full, the entry with the smallest bound is replaced, as small bounds are
+ * found near the leaves and are cheap to compute again.
+ */
+class TranspositionTable {
+public:
+    static constexpr int BUCKET_ENTRIES = 8;
+
+    /// @param megabytes Memory used by the table, rounded down to a power of two
+    TranspositionTable(size_t megabytes = 64) {
+        size_t buckets = 1;
+        while (buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) buckets *= 2;
+        mask = buckets - 1;
+        table.reset(new Bucket[buckets]);
+        clear();
+    }
+
+    void clear() {
+        for (size_t b = 0; b <= mask; b++)
+            for (auto& e: table[b].entries) e.store(0, std::memory_order_relaxed);
+    }
+
+    /// @return Returns the bound stored for a state, or 0 if it is unknown
+    int lookup(uint64_t hash) const {
+        const Bucket& bucket = table[hash & mask];
+        uint64_t t = tag(hash);
+        for (const auto& e: bucket.entries) {
+            uint64_t v = e.load(std::memory_order_relaxed);
+            if ((v >> 8) == t) return v & 0xFF;
+        }
+        return 0;
+    }
+
+    /**
+     * Records that a state needs at least `bound` moves. Keeps the largest bound if the
+     * state is already present.
+     */
+    void store(uint64_t hash, int bound) {
+        Bucket& bucket = table[hash & mask];
+        uint64_t t = tag(hash);
+        uint64_t wanted = (t << 8) | uint64_t(bound);
+
+        std::atomic<uint64_t>* victim = nullptr;
+        uint64_t victim_value = ~0ull;
+        for (auto& e: bucket.entries) {
+            uint64_t v = e.load(std::memory_order_relaxed);
+            if ((v >> 8) == t) {
+                // Same state: only raise the bound
+                while ((v >> 8) == t && (v & 0xFF) < uint64_t(bound)) {
+                    if (e.compare_exchange_weak(v, wanted, std::memory_order_relaxed)) return;
+                }
+                return;
+            }
+            if ((v & 0xFF) < (victim_value & 0xFF) || v == 0) {
+                victim = &e;
+                victim_value = v;
+                if (v == 0) break;
+            }
+        }
+        // If another thread changed the victim in the meantime, the entry is simply dropped
+        if (victim && (victim_value & 0xFF) <= uint64_t(bound))
+            victim->compare_exchange_strong(victim_value, wanted, std::memory_order_relaxed);
+    }
+
+private:
+    struct alignas(64) Bucket {
+        std::atomic<uint64_t> entries[BUCKET_ENTRIES];
+    };
+
+    std::unique_ptr<Bucket[]> table;
+    size_t mask;
+
+    /// The tag drops the lowest byte of the hash, and is never 0 (empty entry)
+    static uint64_t tag(uint64_t hash) { return (hash >> 8) | 1; }
+};
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef TWOPHASE_H
+#define TWOPHASE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "cubestate.cpp"
+#include "pattern_database.cpp"
+
+/**
+ * Kociemba's two-phase solver: fast, short (but not optimal) solutions of the 3x3x3 cube.
+ *
+ * Phase 1 brings the cube into the subgroup G1 = <U, D, R2, L2, F2, B2>: all the corners and
+ * edges oriented, and the 4 edges of the middle slice (FR, FL, BL, BR) in that slice.
+ * Phase 2 solves the cube within G1.
+ *
+ * Each phase works on small coordinates, with one move table per coordinate and two pruning
+ * tables (exact distances in a pair of coordinates) as heuristic. All the tables are built
+ * in memory by the constructor (about 4 MB, a few hundred milliseconds).
+ */
+class TwoPhaseSolver {
+public:
+    static constexpr uint32_t TWISTS = 2187;
+    static constexpr uint32_t FLIPS = 2048;
+    static constexpr uint32_t SLICES = 495;
+    static constexpr uint32_t CORNER_PERMS = 40320;
+    static constexpr uint32_t EDGE_PERMS = 40320;
+    static constexpr uint32_t SLICE_PERMS = 24;
+
+    TwoPhaseSolver() {
+        std::vector<Move> all, phase2 = phase2_moves();
+        for (int m = 0; m < MOVE_COUNT; m++) all.push_back(Move(m));
+
+        twist_move = move_table(TWISTS, all, twist);
+        flip_move = move_table(FLIPS, all, flip);
+        slice_move = move_table(SLICES, all, slice);
+        corner_perm_move = move_table(CORNER_PERMS, phase2, corner_permutation);
+        edge_perm_move = move_table(EDGE_PERMS, phase2, edge_permutation);
+        slice_perm_move = move_table(SLICE_PERMS, phase2, slice_permutation);
+
+        slice_twist_prune = pruning_table(SLICES, slice_move, TWISTS, twist_move, all);
+        slice_flip_prune = pruning_table(SLICES, slice_move, FLIPS, flip_move, all);
+        corner_prune = pruning_table(SLICE_PERMS, slice_perm_move, CORNER_PERMS, corner_perm_move, phase2);
+        edge_prune = pruning_table(SLICE_PERMS, slice_perm_move, EDGE_PERMS, edge_perm_move, phase2);
+
+        for (int last = 0; last <= NO_FACE; last++)
+            for (Move m: canonical_successors(last))
+                if (std::find(phase2.begin(), phase2.end(), m) != phase2.end())
+                    phase2_successors[last].push_back(m);
+    }
+
+    /// @return Returns a solver shared by the whole program, built at its first use
+    static const TwoPhaseSolver& instance() {
+        static const TwoPhaseSolver solver;
+        return solver;
+    }
+
+    /**
+     * Finds a solution of at most `max_length` moves. Phase 1 is searched by increasing
+     * length, so the first solution found is usually within a few moves of the optimum.
+     * Can be called from several threads at once.
+     *
+     * @return Returns false if there is no such solution
+     */
+    bool solve(const CubeState& start, std::vector<Move>& solution, int max_length = 24) const {
+        solution.clear();
+        std::vector<Move> path;
+        for (int length = 0; length <= max_length; length++)
+            if (phase1(start, twist(start), flip(start), slice(start), length, NO_FACE, path, solution, max_length))
+                return true;
+        return false;
+    }
+
+private:
+    std::vector<uint16_t> twist_move, flip_move, slice_move;
+    std::vector<uint16_t> corner_perm_move, edge_perm_move, slice_perm_move;
+    std::vector<uint8_t> slice_twist_prune, slice_flip_prune, corner_prune, edge_prune;
+    std::array<std::vector<Move>, NO_FACE + 1> phase2_successors;
+
+    static std::vector<Move> phase2_moves() { return {U1, U2, U3, D1, D2, D3, R2, L2, F2, B2}; }
+
+    static bool is_phase2_move(Move m) {
+        return move_face(m) == FACE_U || move_face(m) == FACE_D || move_power(m) == 2;
+    }
+
+    /// Orientation of the first 7 corners, in base 3
+    static uint32_t twist(const CubeState& s) {
+        uint32_t t = 0;
+        for (int i = 0; i < CubeState::CORNERS - 1; i++) t = t * 3 + s.co[i];
+        return t;
+    }
+
+    /// Orientation of the first 11 edges, in base 2
+    static uint32_t flip(const CubeState& s) {
+        uint32_t f = 0;
+        for (int i = 0; i < CubeState::EDGES - 1; i++) f = f * 2 + s.eo[i];
+        return f;
+    }
+
+    /// Positions of the 4 slice edges among the 12 (which are occupied, not by which edge)
+    static uint32_t slice(const CubeState& s) {
+        uint32_t r = 0;
+        int k = 0;
+        for (int j = CubeState::EDGES - 1; j >= 0; j--)
+            if (s.ep[j] >= 8) r += binomial(CubeState::EDGES - 1 - j, ++k);
+        return r;
+    }
+
+    static uint32_t corner_permutation(const CubeState& s) { return rank_permutation(s.cp.data(), 8); }
+
+    /// Permutation of the 8 edges of the U and D faces (only meaningful in G1)
+    static uint32_t edge_permutation(const CubeState& s) { return rank_permutation(s.ep.data(), 8); }
+
+    /// Permutation of the 4 slice edges (only meaningful in G1)
+    static uint32_t slice_permutation(const CubeState& s) {
+        uint8_t p[4];
+        for (int i = 0; i < 4; i++) p[i] = s.ep[8 + i] - 8;
+        return rank_permutation(p, 4);
+    }
+
+    static uint32_t binomial(int n, int k) {
+        if (k > n) return 0;
+        uint32_t r = 1;
+        for (int i = 1; i <= k; i++) r = r * (n - k + i) / i;
+        return r;
+    }
+
+    /**
+     * Move table of a coordinate: the coordinate reached by each move, `MOVE_COUNT` entries per
+     * value. The values are discovered by a breadth-first search from solved with `moves`,
+     * which gives a state for each value without having to build one from the coordinate.
+     */
+    static std::vector<uint16_t> move_table(uint32_t size, const std::vector<Move>& moves,
+                                            uint32_t (*coordinate)(const CubeState&)) {
+        std::vector<uint16_t> table(size * MOVE_COUNT, 0);
+        std::vector<CubeState> queue = {CubeState()};
+        std::vector<bool> seen(size, false);
+        seen[0] = true;
+        for (size_t q = 0; q < queue.size(); q++) {
+            uint32_t c = coordinate(queue[q]);
+            for (Move m: moves) {
+                CubeState t = queue[q] * CubeState::moves()[m];
+                uint32_t d = coordinate(t);
+                table[c * MOVE_COUNT + m] = d;
+                if (!seen[d]) {
+                    seen[d] = true;
+                    queue.push_back(t);
+                }
+            }
+        }
+        return table;
+    }
+
+    /**
+     * Distance to solved of each pair of coordinates (a, b), at index a * `size_b` + b.
+     */
+    static std::vector<uint8_t> pruning_table(uint32_t size_a, const std::vector<uint16_t>& move_a,
+                                              uint32_t size_b, const std::vector<uint16_t>& move_b,
+                                              const std::vector<Move>& moves) {
+        std::vector<uint8_t> depth(size_a * size_b, 0xFF);
+        std::vector<uint32_t> frontier = {0}, next;
+        depth[0] = 0;
+        for (uint8_t d = 0; !frontier.empty(); d++) {
+            next.clear();
+            for (uint32_t i: frontier) {
+                uint32_t a = i / size_b, b = i % size_b;
+                for (Move m: moves) {
+                    uint32_t j = move_a[a * MOVE_COUNT + m] * size_b + move_b[b * MOVE_COUNT + m];
+                    if (depth[j] == 0xFF) {
+                        depth[j] = d + 1;
+                        next.push_back(j);
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+        return depth;
+    }
+
+    bool phase1(const CubeState& start, uint32_t tw, uint32_t fl, uint32_t sl, int togo, int last_face,
+                std::vector<Move>& path, std::vector<Move>& solution, int max_length) const {
+        if (togo == 0) {
+            if (tw != 0 || fl != 0 || sl != 0) return false;
+            // Ending phase 1 with a move of G1 gives the solutions of a shorter phase 1 again
+            if (!path.empty() && is_phase2_move(path.back())) return false;
+            CubeState s = start;
+            s.apply(path);
+            uint32_t cp = corner_permutation(s), ep = edge_permutation(s), sp = slice_permutation(s);
+            for (int length = 0; length <= max_length - int(path.size()); length++) {
+                solution = path;
+                if (phase2(cp, ep, sp, length, path.empty() ? NO_FACE : move_face(path.back()), solution))
+                    return true;
+            }
+            return false;
+        }
+        if (std::max(slice_twist_prune[sl * TWISTS + tw], slice_flip_prune[sl * FLIPS + fl]) > togo) return false;
+
+        for (Move m: canonical_successors(last_face)) {
+            path.push_back(m);
+            if (phase1(start, twist_move[tw * MOVE_COUNT + m], flip_move[fl * MOVE_COUNT + m],
+                       slice_move[sl * MOVE_COUNT + m], togo - 1, move_face(m), path, solution, max_length))
+                return true;
+            path.pop_back();
+        }
+        return false;
+    }
+
+    bool phase2(uint32_t cp, uint32_t ep, uint32_t sp, int togo, int last_face, std::vector<Move>& path) const {
+        if (std::max(corner_prune[sp * CORNER_PERMS + cp], edge_prune[sp * EDGE_PERMS + ep]) > togo) return false;
+        if (togo == 0) return true;
+
+        for (Move m: phase2_successors[last_face]) {
+            path.push_back(m);
+            if (phase2(corner_perm_move[cp * MOVE_COUNT + m], edge_perm_move[ep * MOVE_COUNT + m],
+                       slice_perm_move[sp * MOVE_COUNT + m], togo - 1, move_face(m), path))
+                return true;
+            path.pop_back();
+        }
+        return false;
+    }
+};
+
+#endif
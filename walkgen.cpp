@@ -0,0 +1,37 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "training_data.cpp"
+
+using std::cout;
+using std::endl;
+
+/**
+ * Writes training samples (random walks from solved) to a file of `TrainingRecord`.
+ *
+ * Usage: WalkGen <output file> [samples] [max depth] [threads]
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        cout << "Usage: WalkGen <output file> [samples] [max depth] [threads]" << endl;
+        return 1;
+    }
+    uint64_t samples = argc > 2 ? std::stoull(argv[2]) : 10000000;
+    int max_depth = argc > 3 ? std::stoi(argv[3]) : 30;
+    unsigned threads = argc > 4 ? std::stoi(argv[4]) : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    RandomWalkGenerator generator(max_depth, threads);
+    auto start = std::chrono::steady_clock::now();
+    if (!generator.generate(argv[1], samples)) {
+        cout << "Cannot write " << argv[1] << endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cout << samples << " samples (" << samples * sizeof(TrainingRecord) << " bytes) in " << seconds << " s: "
+         << samples / seconds << " samples / s" << endl;
+    return 0;
+}
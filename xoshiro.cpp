@@ -0,0 +1,66 @@
+#ifndef XOSHIRO_H
+#define XOSHIRO_H
+
+#include <cstdint>
+
+/**
+ * xoshiro256** (Blackman & Vigna): a small and fast generator of 64 bits random numbers,
+ * good enough for anything but cryptography. Its state is 4 words, seeded with splitmix64.
+ *
+ * `jump()` skips 2^128 numbers, which gives non-overlapping sequences to the threads.
+ */
+class Xoshiro256 {
+public:
+    Xoshiro256(uint64_t seed = 0x9e3779b97f4a7c15ull) {
+        for (uint64_t& w: s) {
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            w = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    /// @return Returns a number in [0, n), without the bias of a modulo (Lemire's method)
+    uint32_t below(uint32_t n) {
+        uint64_t m = (next() >> 32) * n;
+        if (uint32_t(m) < n) {
+            uint32_t threshold = -n % n;
+            while (uint32_t(m) < threshold) m = (next() >> 32) * n;
+        }
+        return m >> 32;
+    }
+
+    void jump() {
+        static const uint64_t JUMP[] = {0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+                                        0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (uint64_t j: JUMP) {
+            for (int b = 0; b < 64; b++) {
+                if (j & (1ull << b))
+                    for (int i = 0; i < 4; i++) t[i] ^= s[i];
+                next();
+            }
+        }
+        for (int i = 0; i < 4; i++) s[i] = t[i];
+    }
+
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+#endif